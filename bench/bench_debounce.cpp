@@ -0,0 +1,181 @@
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <esp_idf_button_events/button.hpp>
+#include <vector>
+
+#include "bounce_model.hpp"
+#include "sim.hpp"
+
+// Debounce quality benchmark. Replays statistical bounce waveforms of each switch model into buttons with different
+// debounce times, and scores each debounce time on added latency, missed presses and spurious events.
+//
+// Usage: bench_debounce [--model snap|tactile|membrane|worn|noisy] [--debounce MS]... [--duration S]
+// Up to one debounce time per button is scored in a single pass, since all buttons are driven with the same waveform.
+
+using namespace ButtonEvents;
+
+namespace {
+  constexpr size_t max_buttons = CONFIG_ESP_BE_MAX_BUTTON_COUNT;
+  constexpr uint64_t period_us = 500000;
+  constexpr uint64_t hold_us = 200000;
+
+  // Every press is expected to produce exactly one of each.
+  constexpr std::array<EventType, 3> expected{EventType::BUTTON_DOWN, EventType::BUTTON_UP, EventType::BUTTON_PRESS};
+
+  struct Score {
+    std::array<size_t, static_cast<size_t>(EventType::BUTTON_HELD) + 1> counts;  ///< Events within the current press.
+    bool down_seen;
+    std::vector<uint64_t> latencies;
+    size_t missed;
+    size_t spurious;
+  };
+
+  // Names identify the buttons in logs and timelines.
+  constexpr std::array<const char*, 8> names{"debounce0", "debounce1", "debounce2", "debounce3",
+                                             "debounce4", "debounce5", "debounce6", "debounce7"};
+  static_assert(max_buttons <= names.size());
+
+  std::array<Button*, max_buttons> buttons;
+  std::array<Score, max_buttons> scores;
+  uint64_t press_start = 0;
+
+  size_t index_of(const Button* button) { return std::find(buttons.begin(), buttons.end(), button) - buttons.begin(); }
+
+  void handler(void* handler_args, esp_event_base_t base, int32_t id, void* event_data) {
+    auto event = EventData(event_data);
+    auto& score = scores[index_of(event.button)];
+    score.counts[static_cast<size_t>(event.event)]++;
+    if(event.event == EventType::BUTTON_DOWN && !score.down_seen) {
+      score.down_seen = true;
+      score.latencies.push_back(Sim::now() - press_start);
+    }
+  }
+
+  // Score the events of the press which just ended, and start the next.
+  void end_press(size_t count) {
+    for(size_t i = 0; i < count; i++) {
+      auto& score = scores[i];
+      auto missed = false;
+      for(auto event: expected) {
+        auto n = score.counts[static_cast<size_t>(event)];
+        missed |= n == 0;
+        score.spurious += n > 1 ? n - 1 : 0;
+      }
+      // A press should never be classified as anything else.
+      for(auto event: {EventType::BUTTON_LONG_PRESS, EventType::BUTTON_HELD}) {
+        score.spurious += score.counts[static_cast<size_t>(event)];
+      }
+      score.missed += missed;
+      score.counts = {};
+      score.down_seen = false;
+    }
+  }
+
+  void create_buttons(const std::vector<size_t>& debounce_ms) {
+    for(size_t i = 0; i < debounce_ms.size(); i++) {
+      buttons[i] = Button::create(names[i], static_cast<gpio_num_t>(i))
+                     .debounce_ms(debounce_ms[i])
+                     .short_press_ms(50)
+                     .long_press_ms(1000);
+      for(auto event: {EventType::BUTTON_DOWN, EventType::BUTTON_UP, EventType::BUTTON_PRESS, EventType::BUTTON_LONG_PRESS}) {
+        buttons[i]->add_handler(handler, nullptr, event);
+      }
+    }
+  }
+
+  uint64_t percentile(std::vector<uint64_t>& values, double p) {
+    if(values.empty()) {
+      return 0;
+    }
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, static_cast<size_t>(p * values.size()))];
+  }
+
+  void run(const Bounce::Model& model, const std::vector<size_t>& debounce_ms, double duration_s) {
+    auto count = debounce_ms.size();
+    // Buttons are active low, let every button settle released before starting.
+    for(size_t i = 0; i < count; i++) {
+      Sim::set_level(static_cast<gpio_num_t>(i), true);
+    }
+    Sim::advance(period_us);
+    scores = {};
+
+    auto generator = Bounce::Generator(model, 1234);
+    auto presses = std::max<size_t>(1, duration_s * 1e6 / period_us);
+    for(size_t p = 0; p < presses; p++) {
+      std::vector<Bounce::Edge> edges;
+      press_start = Sim::now();
+      generator.press(edges, press_start, hold_us, period_us);
+      for(auto& edge: edges) {
+        Sim::advance_to(edge.time);
+        for(size_t i = 0; i < count; i++) {
+          Sim::set_level(static_cast<gpio_num_t>(i), !edge.level);
+        }
+      }
+      Sim::advance_to(press_start + period_us);
+      end_press(count);
+    }
+
+    // The lowest debounce time with no missed or spurious events is recommended.
+    const size_t* safe = nullptr;
+    for(size_t i = 0; i < count; i++) {
+      auto& score = scores[i];
+      std::printf("%9s %9zu %8zu %8llu %8llu %8zu %9zu\n", model.name, debounce_ms[i], presses,
+                  static_cast<unsigned long long>(percentile(score.latencies, 0.5)),
+                  static_cast<unsigned long long>(percentile(score.latencies, 0.99)), score.missed, score.spurious);
+      if(!safe && !score.missed && !score.spurious) {
+        safe = &debounce_ms[i];
+      }
+    }
+    if(safe) {
+      std::printf("%9s lowest safe debounce: %zu ms\n", model.name, *safe);
+    }
+    else {
+      std::printf("%9s lowest safe debounce: none\n", model.name);
+    }
+  }
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::vector<const Bounce::Model*> models;
+  std::vector<size_t> debounce_ms;
+  double duration = 250;
+
+  for(int i = 1; i + 1 < argc; i += 2) {
+    if(!std::strcmp(argv[i], "--model")) {
+      for(auto& model: Bounce::models) {
+        if(!std::strcmp(argv[i + 1], model.name)) {
+          models.push_back(&model);
+        }
+      }
+    }
+    else if(!std::strcmp(argv[i], "--debounce") && debounce_ms.size() < max_buttons) {
+      debounce_ms.push_back(std::atoi(argv[i + 1]));
+    }
+    else if(!std::strcmp(argv[i], "--duration")) {
+      duration = std::atof(argv[i + 1]);
+    }
+  }
+  if(models.empty()) {
+    for(auto& model: Bounce::models) {
+      models.push_back(&model);
+    }
+  }
+  if(debounce_ms.empty()) {
+    debounce_ms = {1, 3, 5, 10, 20, 40};
+    debounce_ms.resize(std::min(debounce_ms.size(), max_buttons));
+  }
+  std::sort(debounce_ms.begin(), debounce_ms.end());
+
+  create_buttons(debounce_ms);
+
+  // Latency is from the first press edge to the BUTTON_DOWN handler, in virtual us.
+  std::printf("%9s %9s %8s %8s %8s %8s %9s\n", "model", "debounce", "presses", "p50 us", "p99 us", "missed", "spurious");
+  for(auto model: models) {
+    run(*model, debounce_ms, duration);
+  }
+  return 0;
+}
@@ -0,0 +1,85 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <esp_idf_button_events/button.hpp>
+#include <tuple>
+
+#include "sim.hpp"
+
+// Dispatch cost of raw handlers, which cast their argument to call a member function, against typed member function
+// handlers. Each kind is registered on its own button, which is pressed repeatedly through the simulator.
+//
+// Usage: bench_handlers [--duration S]
+
+using namespace ButtonEvents;
+
+namespace {
+  constexpr uint64_t period_us = 100000;
+  constexpr size_t handlers_per_event = 4;
+
+  struct Object {
+    uint64_t calls = 0;
+    void handler(EventView event) { calls += event.sequence() != 0xFF; }
+  };
+
+  void raw_handler(void* handler_args, esp_event_base_t base, int32_t id, void* event_data) {
+    static_cast<Object*>(handler_args)->handler(EventView(event_data));
+  }
+
+  struct Result {
+    double loop_ns_per_call;
+    double wall_ns_per_call;
+  };
+
+  Result run(Button* button, Object& object, double duration_s) {
+    auto pin = static_cast<gpio_num_t>(button->index());
+    Sim::set_level(pin, true);
+    Sim::advance(1000000);
+    Sim::reset_stats();
+    object.calls = 0;
+
+    auto wall_start = std::chrono::steady_clock::now();
+    for(uint64_t t = 0; t < duration_s * 1e6; t += period_us) {
+      Sim::set_level(pin, false);
+      Sim::advance(period_us / 2);
+      Sim::set_level(pin, true);
+      Sim::advance(period_us / 2);
+    }
+    auto wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - wall_start).count();
+    auto calls = object.calls ? static_cast<double>(object.calls) : 1.0;
+    return {Sim::stats().loop_cpu_ns / calls, wall_ns / calls};
+  }
+}  // namespace
+
+int main(int argc, char** argv) {
+  double duration = 100;
+  for(int i = 1; i + 1 < argc; i += 2) {
+    if(!std::strcmp(argv[i], "--duration")) {
+      duration = std::atof(argv[i + 1]);
+    }
+  }
+
+  Object raw_object;
+  Object typed_object;
+  Button* raw = Button::create("handlers_raw", GPIO_NUM_0).debounce_ms(5).short_press_ms(10);
+  Button* typed = Button::create("handlers_typed", GPIO_NUM_1).debounce_ms(5).short_press_ms(10);
+  for(size_t i = 0; i < handlers_per_event; i++) {
+    for(auto event: {EventType::BUTTON_DOWN, EventType::BUTTON_UP, EventType::BUTTON_PRESS}) {
+      raw->add_handler(raw_handler, &raw_object, event);
+      if(!typed->add_handler(&typed_object, &Object::handler, event)) {
+        std::fprintf(stderr, "Typed handler table is full\n");
+        return 1;
+      }
+    }
+  }
+
+  // Loop times are host ns spent in event loop tasks per handler call, including the dispatch of the event loop.
+  std::printf("%8s %12s %12s %12s\n", "handler", "calls", "loop ns", "wall ns");
+  for(auto [name, button, object]: {std::tuple{"raw", raw, &raw_object}, std::tuple{"typed", typed, &typed_object}}) {
+    auto result = run(button, *object, duration);
+    std::printf("%8s %12llu %12.1f %12.1f\n", name, static_cast<unsigned long long>(object->calls), result.loop_ns_per_call,
+                result.wall_ns_per_call);
+  }
+  return 0;
+}
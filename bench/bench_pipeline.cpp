@@ -0,0 +1,228 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <esp_idf_button_events/button.hpp>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "hooks_file_sink.hpp"
+#include "sim.hpp"
+
+// Throughput and latency benchmark of the event pipeline, driven through the simulator.
+//
+// Usage: bench_pipeline [--buttons N] [--rate HZ] [--bounce none|light|heavy] [--handler-us US] [--duration S] [--timeline FILE]
+// Options which are not given are swept over their default values. A timeline of all scenarios is written to FILE.
+//
+// The simulator runs the manager and event loop in zero virtual time, so without a handler cost every latency is the
+// debounce time. Handlers spend --handler-us of virtual time per event, which makes events queue behind each other.
+
+using namespace ButtonEvents;
+
+namespace {
+  constexpr size_t max_buttons = CONFIG_ESP_BE_MAX_BUTTON_COUNT;
+
+  struct BounceProfile {
+    const char* name;
+    size_t bounces;      ///< Extra edge pairs before the contact settles.
+    uint64_t spacing_us;  ///< Time between bounce edges.
+  };
+
+  constexpr std::array<BounceProfile, 3> bounce_profiles{{{"none", 0, 0}, {"light", 2, 300}, {"heavy", 8, 250}}};
+
+  struct Scenario {
+    size_t buttons;
+    double rate_hz;  ///< Presses per second, per button.
+    BounceProfile bounce;
+    uint64_t handler_us;  ///< Virtual time spent by the handler for each event.
+    double duration_s;
+  };
+
+  struct Edge {
+    uint64_t time;
+    size_t button;
+    bool level;
+    bool first;  ///< First edge of a transition, latency is measured from here.
+  };
+
+  // Names identify the buttons in logs and timelines.
+  constexpr std::array<const char*, 8> names{"bench0", "bench1", "bench2", "bench3", "bench4", "bench5", "bench6", "bench7"};
+  static_assert(max_buttons <= names.size());
+
+  std::array<Button*, max_buttons> buttons;
+  std::array<uint64_t, max_buttons> transition_start;
+  std::vector<uint64_t> latencies;
+  uint64_t handled = 0;
+  uint64_t handler_us = 0;
+
+  size_t index_of(const Button* button) { return std::find(buttons.begin(), buttons.end(), button) - buttons.begin(); }
+
+  void handler(void* handler_args, esp_event_base_t base, int32_t id, void* event_data) {
+    auto event = EventData(event_data);
+    handled++;
+    if(event.event == EventType::BUTTON_DOWN || event.event == EventType::BUTTON_UP) {
+      latencies.push_back(Sim::now() - transition_start[index_of(event.button)]);
+    }
+    Sim::spend(handler_us);
+  }
+
+  void create_buttons() {
+    for(size_t i = 0; i < max_buttons; i++) {
+      buttons[i] = Button::create(names[i], static_cast<gpio_num_t>(i))
+                     .debounce_ms(5)
+                     .short_press_ms(10)
+                     .long_press_ms(1000)
+                     .hold_press_ms(1000)
+                     .hold_repeat_ms(200);
+      for(auto event: {EventType::BUTTON_DOWN, EventType::BUTTON_UP, EventType::BUTTON_PRESS, EventType::BUTTON_LONG_PRESS,
+                       EventType::BUTTON_HELD}) {
+        buttons[i]->add_handler(handler, nullptr, event);
+      }
+    }
+  }
+
+  // Buttons are active low. Each press is held for half the press period.
+  std::vector<Edge> generate(const Scenario& scenario, uint64_t start) {
+    std::vector<Edge> edges;
+    std::mt19937 rng(1234);
+    const uint64_t period = 1e6 / scenario.rate_hz;
+    const uint64_t end = start + scenario.duration_s * 1e6;
+    std::uniform_int_distribution<uint64_t> jitter(0, period / 10);
+
+    auto transition = [&](uint64_t t, size_t button, bool level) {
+      edges.push_back({t, button, level, true});
+      for(size_t b = 0; b < scenario.bounce.bounces; b++) {
+        t += scenario.bounce.spacing_us;
+        edges.push_back({t, button, !level, false});
+        t += scenario.bounce.spacing_us;
+        edges.push_back({t, button, level, false});
+      }
+    };
+
+    for(size_t button = 0; button < scenario.buttons; button++) {
+      for(uint64_t t = start + button * period / scenario.buttons; t + period < end; t += period) {
+        auto press = t + jitter(rng);
+        transition(press, button, false);
+        transition(press + period / 2, button, true);
+      }
+    }
+    std::stable_sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b) { return a.time < b.time; });
+    return edges;
+  }
+
+  uint64_t percentile(std::vector<uint64_t>& values, double p) {
+    if(values.empty()) {
+      return 0;
+    }
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, static_cast<size_t>(p * values.size()))];
+  }
+
+  void settle() {
+    for(size_t i = 0; i < max_buttons; i++) {
+      Sim::set_level(static_cast<gpio_num_t>(i), true);
+    }
+    Sim::advance(5000000);
+    Sim::reset_stats();
+    latencies.clear();
+    handled = 0;
+  }
+
+  void run(const Scenario& scenario) {
+    settle();
+    handler_us = scenario.handler_us;
+    auto start = Sim::now();
+    auto edges = generate(scenario, start);
+
+    auto wall_start = std::chrono::steady_clock::now();
+    for(auto& edge: edges) {
+      Sim::advance_to(edge.time);
+      if(edge.first) {
+        transition_start[edge.button] = edge.time;
+      }
+      Sim::set_level(static_cast<gpio_num_t>(edge.button), edge.level);
+    }
+    Sim::advance_to(start + scenario.duration_s * 1e6);
+    auto wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - wall_start).count();
+
+    auto stats = Sim::stats();
+    auto p50 = percentile(latencies, 0.5);
+    auto p99 = percentile(latencies, 0.99);
+    auto max = latencies.empty() ? 0 : latencies.back();
+
+    std::printf("%7zu %7.1f %7s %6llu %8zu %10.1f %12.0f %8llu %8llu %8llu %10.0f %10.0f %6zu %8llu\n", scenario.buttons, scenario.rate_hz,
+                scenario.bounce.name, static_cast<unsigned long long>(scenario.handler_us), edges.size(), handled / scenario.duration_s, handled / (wall_ns / 1e9),
+                static_cast<unsigned long long>(p50), static_cast<unsigned long long>(p99), static_cast<unsigned long long>(max),
+                handled ? static_cast<double>(stats.service_cpu_ns) / handled : 0.0,
+                handled ? static_cast<double>(stats.loop_cpu_ns) / handled : 0.0, stats.loop_peak_depth,
+                static_cast<unsigned long long>(stats.loop_blocked_posts));
+  }
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::vector<size_t> button_counts;
+  std::vector<double> rates;
+  std::vector<BounceProfile> bounces;
+  std::vector<uint64_t> handler_costs;
+  double duration = 10;
+  std::unique_ptr<Hooks::FileSink> timeline;
+
+  for(int i = 1; i + 1 < argc; i += 2) {
+    if(!std::strcmp(argv[i], "--buttons")) {
+      button_counts.push_back(std::min<size_t>(std::atoi(argv[i + 1]), max_buttons));
+    }
+    else if(!std::strcmp(argv[i], "--rate")) {
+      rates.push_back(std::atof(argv[i + 1]));
+    }
+    else if(!std::strcmp(argv[i], "--bounce")) {
+      for(auto& profile: bounce_profiles) {
+        if(!std::strcmp(argv[i + 1], profile.name)) {
+          bounces.push_back(profile);
+        }
+      }
+    }
+    else if(!std::strcmp(argv[i], "--handler-us")) {
+      handler_costs.push_back(std::strtoull(argv[i + 1], nullptr, 10));
+    }
+    else if(!std::strcmp(argv[i], "--duration")) {
+      duration = std::atof(argv[i + 1]);
+    }
+    else if(!std::strcmp(argv[i], "--timeline")) {
+      timeline = std::make_unique<Hooks::FileSink>(argv[i + 1]);
+      Hooks::set_sink(Hooks::FileSink::write, timeline.get());
+    }
+  }
+  if(button_counts.empty()) {
+    button_counts = {1, 2, 4, max_buttons};
+  }
+  if(rates.empty()) {
+    rates = {1, 5, 20};
+  }
+  if(bounces.empty()) {
+    bounces = {bounce_profiles.begin(), bounce_profiles.end()};
+  }
+  if(handler_costs.empty()) {
+    handler_costs = {0, 2000};
+  }
+
+  create_buttons();
+
+  std::printf("Latencies are edge to handler entry in virtual us, the debounce time plus queueing behind the handler cost.\n"
+              "Manager and event loop CPU times are host ns per handled event, they are not modelled in virtual time.\n");
+  std::printf("%7s %7s %7s %6s %8s %10s %12s %8s %8s %8s %10s %10s %6s %8s\n", "buttons", "rate", "bounce", "hdl us", "edges", "events/s",
+              "host evt/s", "p50 us", "p99 us", "max us", "mgr ns/ev", "loop ns/ev", "depth", "blocked");
+  for(auto count: button_counts) {
+    for(auto rate: rates) {
+      for(auto& bounce: bounces) {
+        for(auto cost: handler_costs) {
+          run({count, rate, bounce, cost, duration});
+        }
+      }
+    }
+  }
+  Hooks::set_sink(nullptr, nullptr);
+  return 0;
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+/**
+ * @brief Statistical models of mechanical contact bounce, used to generate realistic pin waveforms on the host.
+ * @details A transition starts with a clean edge to the new level, followed by a random number of bounces. Each
+ * bounce briefly returns the contact to the old level. Gaps between bounce edges are log-normally distributed and
+ * grow with each bounce, as the contact energy decays. Press and release are modelled separately, since switches
+ * commonly bounce more on one than the other. ESD like glitches are short pulses on an otherwise stable level.
+ */
+namespace Bounce {
+  /**
+   * @brief Bounce behaviour of a single transition, either press or release.
+   */
+  struct Transition {
+    double mean_bounces;   ///< Mean number of bounces, Poisson distributed.
+    double median_gap_us;  ///< Median time between bounce edges.
+    double gap_sigma;      ///< Log-normal shape of the gap between bounce edges.
+    double gap_growth;     ///< Multiplier applied to the gap after each bounce.
+  };
+
+  /**
+   * @brief Bounce model of a switch type.
+   */
+  struct Model {
+    const char* name;
+    Transition press;
+    Transition release;
+    double glitch_rate_hz;  ///< Rate of glitches while the contact is stable, Poisson distributed.
+    double glitch_us;       ///< Maximum width of a glitch, uniformly distributed.
+  };
+
+  constexpr std::array<Model, 5> models{{
+    {"snap", {0.2, 50, 0.3, 1.0}, {0.1, 50, 0.3, 1.0}, 0, 0},
+    {"tactile", {3, 150, 0.6, 1.3}, {1.5, 100, 0.6, 1.2}, 0, 0},
+    {"membrane", {5, 300, 0.6, 1.2}, {3, 250, 0.6, 1.2}, 0, 0},
+    {"worn", {6, 400, 0.8, 1.2}, {8, 400, 0.8, 1.15}, 0, 0},
+    {"noisy", {3, 150, 0.6, 1.3}, {1.5, 100, 0.6, 1.2}, 2, 50},
+  }};
+
+  /**
+   * @brief A single pin edge.
+   */
+  struct Edge {
+    uint64_t time;  ///< Time of the edge, in microseconds.
+    bool level;     ///< Logic level of the contact after the edge, true when closed.
+  };
+
+  /**
+   * @brief Generates contact waveforms from a model. Generation is deterministic for a given seed.
+   */
+  class Generator {
+   public:
+    Generator(const Model& model, uint32_t seed) : _model(model), _rng(seed) {}
+
+    /**
+     * @brief Append a transition to a new contact level, including its bounces.
+     * @param edges The waveform to append to.
+     * @param time The time of the first edge.
+     * @param closed The level to transition to.
+     * @return uint64_t The time of the last edge, after which the contact is stable.
+     */
+    uint64_t transition(std::vector<Edge>& edges, uint64_t time, bool closed) {
+      const auto& t = closed ? _model.press : _model.release;
+      edges.push_back({time, closed});
+      auto bounces = t.mean_bounces > 0 ? std::poisson_distribution<size_t>(t.mean_bounces)(_rng) : 0;
+      auto gap = std::lognormal_distribution<double>(std::log(std::max(t.median_gap_us, 1.0)), t.gap_sigma);
+      auto scale = 1.0;
+      for(size_t b = 0; b < bounces; b++) {
+        time += std::max<uint64_t>(1, gap(_rng) * scale);
+        edges.push_back({time, !closed});
+        time += std::max<uint64_t>(1, gap(_rng) * scale);
+        edges.push_back({time, closed});
+        scale *= t.gap_growth;
+      }
+      return time;
+    }
+
+    /**
+     * @brief Append glitches to a period where the contact is stable.
+     * @param edges The waveform to append to.
+     * @param start The start of the stable period.
+     * @param end The end of the stable period. No glitch extends past it.
+     * @param closed The stable contact level.
+     */
+    void stable(std::vector<Edge>& edges, uint64_t start, uint64_t end, bool closed) {
+      if(_model.glitch_rate_hz <= 0) {
+        return;
+      }
+      auto interval = std::exponential_distribution<double>(_model.glitch_rate_hz / 1e6);
+      auto width = std::uniform_real_distribution<double>(1, std::max(_model.glitch_us, 1.0));
+      for(auto time = start + static_cast<uint64_t>(interval(_rng)); time < end; time += static_cast<uint64_t>(interval(_rng))) {
+        auto w = static_cast<uint64_t>(width(_rng));
+        if(time + w >= end) {
+          break;
+        }
+        edges.push_back({time, !closed});
+        edges.push_back({time + w, closed});
+      }
+    }
+
+    /**
+     * @brief Append a complete press and release, including the stable periods after each.
+     * @param edges The waveform to append to.
+     * @param time The time the press starts.
+     * @param hold_us Time from the start of the press to the start of the release.
+     * @param period_us Time from the start of the press to the start of the next press.
+     */
+    void press(std::vector<Edge>& edges, uint64_t time, uint64_t hold_us, uint64_t period_us) {
+      auto settled = transition(edges, time, true);
+      stable(edges, settled, time + hold_us, true);
+      settled = transition(edges, time + hold_us, false);
+      stable(edges, settled, time + period_us, false);
+    }
+
+   private:
+    const Model& _model;
+    std::mt19937 _rng;
+  };
+}  // namespace Bounce
@@ -4,6 +4,10 @@
 #include "button_storage.hpp"
 #include "event_bits.hpp"
 #include "event_manager.hpp"
+#include "hal.hpp"
+#include "hooks_internal.hpp"
+#include "latency_recorder.hpp"
+#include "trace_recorder.hpp"
 
 #define TAG "Event Buttons"
 
@@ -11,57 +15,153 @@ using namespace EventBit;
 
 
 namespace ButtonEvents {
+  ESP_EVENT_DEFINE_BASE(BUTTON_EVENT);
+  ESP_EVENT_DEFINE_BASE(BUTTON_BATCH_EVENT);
+
   constexpr auto Manager = EventManager::instance;
 
+  void init() { Manager().init(); }
+
+  EventManager* create_manager(const ManagerConfig& config) { return EventManager::create(config); }
+
+#ifdef CONFIG_ESP_BE_STATS
+  Stats stats() { return Manager().stats(); }
+
+  void reset_stats() { Manager().reset_stats(); }
+#endif
+
+#ifdef CONFIG_ESP_BE_HANDLER_WATCHDOG
+  namespace Watchdog {
+    void set_budget_us(const uint32_t budget_us) { Manager().set_handler_budget_us(budget_us); }
+
+    void set_callback(Callback callback, void* arg) { Manager().set_overrun_callback(callback, arg); }
+
+    size_t handler_count() { return Manager().handler_count(); }
+
+    HandlerStats handler_stats(const size_t index) { return Manager().handler_stats(index); }
+  }  // namespace Watchdog
+#endif
+
+#ifdef CONFIG_ESP_BE_EVENT_RING
+  EventRing::Reader ring_reader(const uint32_t events) { return Manager().ring_reader(events); }
+#endif
+
   ButtonBuilder Button::create(const char* name, gpio_num_t pin) { return ButtonBuilder(name, pin); }
 
   constexpr State to_state(bool level, bool inverted) { return level ^ inverted ? State::NOT_PRESSED : State::PRESSED; }
 
   void IRAM_ATTR Button::button_isr_handler(void* arg) {
     auto b = static_cast<Button*>(arg);
-    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    Hooks::emit(Hooks::Point::ISR, b->_index);
+    if(b->_critical) {
+      b->_critical_edge();
+    }
+#ifdef CONFIG_ESP_BE_STATS
+    b->_edges.fetch_add(1, std::memory_order_relaxed);
+#endif
+#ifdef CONFIG_ESP_BE_TRACE
+    Trace::record_edge(b->_index, Hal::pin_level(b->_pin));
+#endif
     if(!b->_debounce_active) {
-      xEventGroupSetBitsFromISR(b->_event_group, b->_press_event_bit, &xHigherPriorityTaskWoken);
+#ifdef CONFIG_ESP_BE_LATENCY_HISTOGRAMS
+      Latency::edge(b->_index);
+#endif
+      Hal::signal_set_from_isr(b->_event_group, b->_press_event_bit);
+    }
+  }
+
+  void IRAM_ATTR Button::_critical_edge() {
+    auto level = Hal::pin_level(_pin);
+    if(_glitch_filter_us) {
+      Hal::delay_us(_glitch_filter_us);
+      if(Hal::pin_level(_pin) != level) {
+        // A glitch. The edge back raises another interrupt, which sees no change of state.
+        return;
+      }
     }
-    if(xHigherPriorityTaskWoken) {
-      portYIELD_FROM_ISR();
+    auto state = to_state(level, _inverted);
+    if(state != _critical_state) {
+      _critical_state = state;
+      _critical(this, state, _critical_arg);
     }
   }
 
   void Button::timer_debounce_callback(void* arg) {
     auto b = static_cast<Button*>(arg);
-    b->_current_state = to_state(gpio_get_level(b->_pin), b->_inverted);
-    xEventGroupSetBits(b->_event_group, b->_timer_event_bit);
+    b->_current_state = to_state(Hal::pin_level(b->_pin), b->_inverted);
+    Hooks::emit(Hooks::Point::DEBOUNCE_TIMER, b->_index, static_cast<uint8_t>(b->_current_state));
+#ifdef CONFIG_ESP_BE_LATENCY_HISTOGRAMS
+    Latency::debounced(b->_index);
+#endif
+    Hal::signal_set(b->_event_group, b->_timer_event_bit);
   }
 
   void Button::timer_held_callback(void* arg) {
     auto b = static_cast<Button*>(arg);
-    esp_timer_start_once(b->_held_timer, b->_hold_repeat);
-    xEventGroupSetBits(b->_event_group, b->_repeat_event_bit);
+    Hooks::emit(Hooks::Point::HELD_TIMER, b->_index);
+    Hal::timer_start_once(b->_held_timer, b->_hold_repeat);
+    Hal::signal_set(b->_event_group, b->_repeat_event_bit);
+  }
+
+  State Button::current_state() const {
+    // Poll only buttons have no interrupt attached, so the pin is read directly.
+    return _debounce_timer ? _current_state : to_state(Hal::pin_level(_pin), _inverted);
   }
 
-  State Button::current_state() const { return _current_state; }
+  uint64_t Button::last_transition() const { return _transition_time; }
 
-  size_t Button::last_transition() const { return _transition_time; }
+  void* Button::context() const { return _context; }
 
   const char* Button::name() const { return _name; }
 
+  size_t Button::index() const { return _index; }
+
+  Button* Button::from_index(const size_t index) { return EventManager::button(index); }
+
+#ifdef CONFIG_ESP_BE_LATENCY_HISTOGRAMS
+  Latency::Histogram Button::latency(const Latency::Stage stage) const { return Latency::histogram(_index, stage); }
+#endif
+
   void Button::_pin_init(const bool pull_up, const bool pull_down) {
-    gpio_config_t io_conf = {
-      .pin_bit_mask = 1ULL << _pin,
-      .mode = GPIO_MODE_INPUT,
-      .pull_up_en = (pull_up ? GPIO_PULLUP_ENABLE : GPIO_PULLUP_DISABLE),
-      .pull_down_en = (pull_down ? GPIO_PULLDOWN_ENABLE : GPIO_PULLDOWN_DISABLE),
-      .intr_type = GPIO_INTR_ANYEDGE,
-    };
-    gpio_config(&io_conf);
+    // The interrupt is enabled once the first event is subscribed to.
+    Hal::pin_configure(_pin, pull_up, pull_down);
+  }
 
-    static bool __attribute__((unused)) once = []() {
-      gpio_install_isr_service(0);
-      return true;
-    }();
+#ifdef CONFIG_ESP_BE_EVENT_RING
+  void Button::_join_ring() { EventManager::join_ring(this); }
+#endif
 
-    gpio_isr_handler_add(_pin, Button::button_isr_handler, this);
+  void Button::_allocate(const uint32_t mask) {
+    // TODO Timer naming could somehow also have the button name and type.
+    // Fow now, both timers have the same name.
+    // Timers are created before the interrupt is enabled and before the event is subscribed, since both start them.
+    if((mask & event_mask(EventType::BUTTON_HELD)) && !_held_timer) {
+      _held_timer = Hal::timer_create(Button::timer_held_callback, this, _name);
+    }
+
+    if(!_debounce_timer) {
+      // Buttons are bound to a manager on first use, so the default manager is only created if it is used.
+      if(!_manager) {
+        _manager = &Manager();
+      }
+      _event_group = _manager->event_group(get_group_index(_index));
+      _debounce_timer = Hal::timer_create(Button::timer_debounce_callback, this, _name);
+      _current_state = to_state(Hal::pin_level(_pin), _inverted);
+      _critical_state = _current_state;
+#ifdef CONFIG_ESP_BE_STATS
+      _reported_state = _current_state;
+#endif
+#ifdef CONFIG_ESP_BE_TRACE
+      Trace::record_button({.index = static_cast<uint8_t>(_index),
+                            .inverted = _inverted,
+                            .debounce_us = static_cast<uint32_t>(_debounce),
+                            .short_press_us = static_cast<uint32_t>(_short_press),
+                            .long_press_us = static_cast<uint32_t>(_long_press),
+                            .hold_press_us = static_cast<uint32_t>(_hold_press),
+                            .hold_repeat_us = static_cast<uint32_t>(_hold_repeat)});
+#endif
+      Hal::pin_attach_isr(_pin, Button::button_isr_handler, this);
+    }
   }
 
   Button::Button(const char* name, gpio_num_t pin) :
@@ -77,34 +177,141 @@ namespace ButtonEvents {
     _long_press(ms_to_us(CONFIG_ESP_BE_DEFAULT_LONG_PRESS_MS)),
     _hold_press(ms_to_us(CONFIG_ESP_BE_DEFAULT_HELD_MS)),
     _hold_repeat(ms_to_us(CONFIG_ESP_BE_DEFAULT_HELD_REPEAT_MS)),
+    _manager(nullptr),
+    _event_group(nullptr),
     _current_state{State::NOT_PRESSED},
     _debounce_active{false},
-    _transition_time(0) {
-    auto binding = Manager().add_button(this);
+    _transition_time(0),
+    _sequence{},
+    _held_count(0),
+    _context(nullptr),
+    _debounce_timer(nullptr),
+    _held_timer(nullptr),
+    _critical(nullptr),
+    _critical_arg(nullptr),
+    _glitch_filter_us(0),
+    _critical_state(State::NOT_PRESSED) {
+    auto binding = EventManager::add_button(this);
     assert(binding.valid);
 
-    // TODO Timer naming could somehow also have the button name and type.
-    // Fow now, both timers have the same name.
-    esp_timer_create_args_t timer_param = {.callback = Button::timer_debounce_callback,
-                                           .arg = this,
-                                           .dispatch_method = ESP_TIMER_TASK,
-                                           .name = name,
-                                           .skip_unhandled_events = false};
+    _index = binding.button_index;
+    _press_event_bit = get_bit_mask(Trigger::PRESS_EVENT, binding.button_index);
+    _timer_event_bit = get_bit_mask(Trigger::TIMER_EVENT, binding.button_index);
+    _repeat_event_bit = get_bit_mask(Trigger::REPEAT_EVENT, binding.button_index);
+  }
+
+  HandlerHandle Button::add_handler(esp_event_handler_t handler, void* arg, EventType event, Context context) {
+    _allocate(event_mask(event));
+    if(context == Context::INLINE) {
+      return _manager->add_inline_event(this, event, handler, arg, nullptr);
+    }
+    return _manager->add_event(this, event, handler, arg);
+  }
 
+  HandlerHandle Button::add_handler(Hal::QueueHandle queue, EventType event) {
+    _allocate(event_mask(event));
+    return _manager->add_inline_event(this, event, nullptr, nullptr, queue);
+  }
 
-    esp_timer_create(&timer_param, &_debounce_timer);
+  bool Button::remove_handler(const HandlerHandle& handle) { return handle && handle.manager->remove_handler(handle); }
 
-    timer_param.callback = Button::timer_held_callback;
-    timer_param.name = name;
-    esp_timer_create(&timer_param, &_held_timer);
+  bool Button::subscribe(std::initializer_list<Button*> buttons, const uint32_t events, esp_event_handler_t handler, void* arg) {
+    uint32_t button_mask;
+    auto manager = _bind(buttons.begin(), buttons.size(), events, button_mask);
+    return manager && manager->add_subscription(button_mask, events, handler, arg);
+  }
 
-    _press_event_bit = get_bit_mask(Trigger::PRESS_EVENT, binding.button_index);
-    _timer_event_bit = get_bit_mask(Trigger::TIMER_EVENT, binding.button_index);
-    _repeat_event_bit = get_bit_mask(Trigger::REPEAT_EVENT, binding.button_index);
-    _event_group = Manager().event_group(binding.event_group_index);
+  bool Button::subscribe_batch(std::initializer_list<Button*> buttons, const uint32_t events, esp_event_handler_t handler, void* arg,
+                               const uint32_t window_us) {
+    uint32_t button_mask;
+    auto manager = _bind(buttons.begin(), buttons.size(), events, button_mask);
+    return manager && manager->add_batch_subscription(button_mask, events, handler, arg, window_us);
+  }
+
+  bool Button::subscribe_all(const uint32_t events, esp_event_handler_t handler, void* arg) {
+    std::array<Button*, CONFIG_ESP_BE_MAX_BUTTON_COUNT> buttons;
+    size_t count = 0;
+    for(size_t i = 0; i < buttons.size(); i++) {
+      auto button = EventManager::button(i);
+      if(button && (!button->_manager || button->_manager == &Manager())) {
+        buttons[count++] = button;
+      }
+    }
+    uint32_t button_mask;
+    auto manager = _bind(buttons.data(), count, events, button_mask);
+    return manager && manager->add_subscription(button_mask, events, handler, arg);
+  }
+
+  EventManager* Button::_bind(Button* const* buttons, const size_t count, const uint32_t events, uint32_t& button_mask) {
+    if(!count) {
+      return nullptr;
+    }
+    // Unbound buttons are bound to the default manager by _allocate().
+    auto manager = buttons[0]->_manager ? buttons[0]->_manager : &Manager();
+    button_mask = 0;
+    for(size_t i = 0; i < count; i++) {
+      if((buttons[i]->_manager ? buttons[i]->_manager : &Manager()) != manager) {
+        return nullptr;
+      }
+      button_mask |= 1u << buttons[i]->_index;
+    }
+    for(size_t i = 0; i < count; i++) {
+      buttons[i]->_allocate(events);
+    }
+    return manager;
+  }
+
+  // Typed handlers of all buttons. Entries of removed handlers are only reused once every entry has been used, and
+  // only while no dispatch is running them, since their callable is destroyed on reuse.
+  static std::array<TypedHandler, CONFIG_ESP_BE_MAX_TYPED_HANDLERS> typed_handlers;
+  static std::array<std::atomic<bool>, CONFIG_ESP_BE_MAX_TYPED_HANDLERS> typed_released;
+  static std::array<std::atomic<uint32_t>, CONFIG_ESP_BE_MAX_TYPED_HANDLERS> typed_running;
+  static std::atomic<size_t> typed_handler_count;
+
+  static size_t typed_index(void* handler) { return static_cast<TypedHandler*>(handler) - typed_handlers.data(); }
+
+  TypedHandler* Button::_allocate_handler() {
+    auto index = typed_handler_count.fetch_add(1, std::memory_order_relaxed);
+    if(index < typed_handlers.size()) {
+      return &typed_handlers[index];
+    }
+    typed_handler_count.fetch_sub(1, std::memory_order_relaxed);
+    for(size_t i = 0; i < typed_handlers.size(); i++) {
+      auto released = true;
+      if(!typed_released[i].compare_exchange_strong(released, false, std::memory_order_acquire)) {
+        continue;
+      }
+      // Pairs with _enter_handler(). A dispatch not yet seen running here sees the removal and skips the entry.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if(typed_running[i].load(std::memory_order_relaxed)) {
+        typed_released[i].store(true, std::memory_order_release);
+        continue;
+      }
+      typed_handlers[i].reset();
+      return &typed_handlers[i];
+    }
+    return nullptr;
   }
 
-  void Button::add_handler(esp_event_handler_t handler, void* arg, EventType event) {
-    EventManager::instance().add_event(this, event, handler, arg);
+  void Button::_release_handler(void* handler) { typed_released[typed_index(handler)].store(true, std::memory_order_release); }
+
+  void Button::_enter_handler(void* handler) { typed_running[typed_index(handler)].fetch_add(1, std::memory_order_seq_cst); }
+
+  void Button::_exit_handler(void* handler) { typed_running[typed_index(handler)].fetch_sub(1, std::memory_order_release); }
+
+  void Button::_typed_handler(void* handler_args, esp_event_base_t base, int32_t id, void* event_data) {
+    (*static_cast<TypedHandler*>(handler_args))(EventView(event_data));
   }
+
+#if ESP_BE_COROUTINES
+  Coroutine::Awaitable<EventData> Button::next(EventType event) {
+    _allocate(event_mask(event));
+    return {EventManager::add_waiter, _manager, this, event_mask(event)};
+  }
+
+  Coroutine::TimedAwaitable<EventData> Button::next(EventType event, const size_t timeout_ms) {
+    _allocate(event_mask(event));
+    return {EventManager::add_waiter, _manager, this, event_mask(event), ms_to_us(timeout_ms)};
+  }
+#endif
 };  // namespace ButtonEvents
\ No newline at end of file
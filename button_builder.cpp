@@ -1,7 +1,5 @@
 #include <esp_idf_button_events/button.hpp>
 
-#include "esp_system.h"
-
 namespace ButtonEvents {
   ButtonBuilder::ButtonBuilder(const char* name, gpio_num_t pin) : _button{new Button(name, pin)}, _pull_up(true), _pull_down(false) {}
 
@@ -44,4 +42,21 @@ namespace ButtonEvents {
     _button->_hold_repeat = ms_to_us(ms);
     return *this;
   }
+
+  ButtonBuilder& ButtonBuilder::manager(EventManager* manager) {
+    _button->_manager = manager;
+    return *this;
+  }
+
+  ButtonBuilder& ButtonBuilder::context(void* context) {
+    _button->_context = context;
+    return *this;
+  }
+
+  ButtonBuilder& ButtonBuilder::critical(CriticalCallback callback, void* arg, const uint32_t glitch_filter_us) {
+    _button->_critical = callback;
+    _button->_critical_arg = arg;
+    _button->_glitch_filter_us = glitch_filter_us;
+    return *this;
+  }
 }  // namespace ButtonEvents
\ No newline at end of file
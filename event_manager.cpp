@@ -1,100 +1,732 @@
 #include "event_manager.hpp"
 
-#include "esp_event.h"
+#include <algorithm>
+
+#include "hooks_internal.hpp"
+#include "latency_recorder.hpp"
+#include "trace_recorder.hpp"
+
+#define TAG "Event Buttons"
 
 using namespace EventBit;
 namespace ButtonEvents {
+  namespace {
+    /**
+     * @brief Claim a removed entry for the same button and event, so its event loop registration can be reused.
+     * @details The claimed entry is moved to the next generation and marked busy until it is published with
+     * publish(), so handles of the removed handler no longer match it.
+     * @return size_t The index of the entry, or the table size if there is none.
+     */
+    template<typename entry_type, size_t size>
+    size_t claim(std::array<entry_type, size>& table, const size_t count, const Button* button, const EventType event) {
+      for(size_t i = 0; i < count; i++) {
+        auto& entry = table[i];
+        auto state = entry.state.load(std::memory_order_relaxed);
+        if(entry.button != button || entry.event != event || (state & (EntryState::active | EntryState::busy))) {
+          continue;
+        }
+        if(entry.state.compare_exchange_strong(state, EntryState::make(EntryState::generation(state) + 1, EntryState::busy),
+                                               std::memory_order_relaxed)) {
+          // Orders the busy state before the rewritten fields, for dispatch reading them concurrently.
+          std::atomic_thread_fence(std::memory_order_release);
+          return i;
+        }
+      }
+      return size;
+    }
+
+    template<typename entry_type>
+    uint16_t publish(entry_type& entry) {
+      auto generation = EntryState::generation(entry.state.load(std::memory_order_relaxed));
+      entry.state.store(EntryState::make(generation, EntryState::active), std::memory_order_release);
+      return generation;
+    }
+
+    /**
+     * @brief Check that an entry is still in the state read before its fields.
+     */
+    template<typename entry_type>
+    bool unchanged(const entry_type& entry, const uint32_t state) {
+      std::atomic_thread_fence(std::memory_order_acquire);
+      return entry.state.load(std::memory_order_relaxed) == state;
+    }
+  }  // namespace
 
   EventManager& EventManager::instance() {
-    static EventManager _instance;
+    static EventManager _instance(ManagerConfig{});
+    // Initialise on first use, for applications which don't call init() explicitly.
+    _instance.init();
     return _instance;
   };
 
+  EventManager* EventManager::create(const ManagerConfig& config) {
+    auto manager = new EventManager(config);
+    manager->init();
+    return manager;
+  }
+
   Storage::Binding EventManager::add_button(Button* button) { return _buttons.add(button); }
 
-  EventGroupHandle_t EventManager::event_group(const size_t index) { return _event_groups[index]; }
+  Button* EventManager::button(const size_t index) { return index < CONFIG_ESP_BE_MAX_BUTTON_COUNT ? _buttons[index] : nullptr; }
+
+  Hal::SignalHandle EventManager::event_group(const size_t index) { return _event_groups[index]; }
 
-  void EventManager::add_event(Button* button, EventType event, esp_event_handler_t handler, void* arg) {
-    esp_event_handler_instance_register_with(loop_with_task, button->_name, static_cast<int32_t>(event), handler, arg, nullptr);
+#if ESP_BE_COROUTINES
+  void EventManager::add_waiter(void* manager, Coroutine::Waiter<EventData>& waiter) {
+    auto self = static_cast<EventManager*>(manager);
+    self->_subscribe(static_cast<const Button*>(waiter.source), waiter.mask);
+    waiter.deadline = waiter.timeout ? Hal::time_us() + waiter.timeout : Coroutine::no_deadline();
+    if(self->_waiters.push(&waiter)) {
+      // The manager may be blocked on a later deadline, wake it to recalculate.
+      Hal::signal_set(self->_event_groups[0], wake_bit());
+    }
   }
+#endif
 
-  EventManager::EventManager() {
-    for(auto& event: _event_groups) {
-      event = xEventGroupCreate();
+  uint64_t EventManager::_wait_timeout() {
+    // Pending batches and coroutine waits both need the manager task to wake by their deadline.
+    uint64_t deadline = UINT64_MAX;
+    auto batch_count = _batch_count.load(std::memory_order_acquire);
+    for(size_t i = 0; i < batch_count; i++) {
+      if(_batches[i].buffer.header.count) {
+        deadline = std::min(deadline, _batches[i].deadline);
+      }
     }
+#if ESP_BE_COROUTINES
+    // No deadline is UINT64_MAX, so it never wins the minimum.
+    deadline = std::min(deadline, _waiters.next_deadline());
+#endif
+    if(deadline == UINT64_MAX) {
+      return Hal::wait_forever();
+    }
+    uint64_t now = Hal::time_us();
+    return deadline > now ? deadline - now : 0;
+  }
 
-    xTaskCreate(
-      [](void* arg) {
-        auto manager = static_cast<EventManager*>(arg);
-        manager->task_loop();
-      },
-      "button_event_manager", CONFIG_ESP_BE_TASK_STACK_SIZE, this, CONFIG_ESP_BE_TASK_PRIORITY, NULL);
+  bool EventManager::_owns(const Button* button) {
+    // Buttons without a manager use the default manager once they are allocated.
+    return (button->_manager ? button->_manager : &instance()) == this;
+  }
 
-    // TODO: Using default event loop vs dedicated
-    esp_event_loop_args_t loop_with_task_args = {.queue_size = CONFIG_ESP_BE_EVENT_LOOP_QUEUE_SIZE,
-                                                 .task_name = "loop_task",  // task will be created
-                                                 .task_priority = CONFIG_ESP_BE_EVENT_LOOP_TASK_PRIORITY,
-                                                 .task_stack_size = CONFIG_ESP_BE_EVENT_LOOP_STACK_SIZE,
-                                                 .task_core_id = CONFIG_ESP_BE_EVENT_LOOP_TASK_AFFINITY};
+  // Subscribing publishes the timers created for the events to the manager task, so it is a release paired with the
+  // acquire in _subscribed().
+  void EventManager::_subscribe(const Button* button, const uint32_t mask) {
+    _subscriptions[button->_index].fetch_or(mask, std::memory_order_release);
+#ifdef CONFIG_ESP_BE_TRACE
+    // Replay subscribes to the same events, since only these are recorded.
+    Trace::record_subscription(button->_index, mask);
+#endif
+  }
 
-    ESP_ERROR_CHECK(esp_event_loop_create(&loop_with_task_args, &loop_with_task));
+  bool EventManager::_subscribed(const Button* button, const EventType event) const {
+    return _subscriptions[button->_index].load(std::memory_order_acquire) & event_mask(event);
+  }
+
+#ifdef CONFIG_ESP_BE_EVENT_RING
+  EventRing::Reader EventManager::ring_reader(const uint32_t events) {
+    _ring_events.fetch_or(events, std::memory_order_relaxed);
+    _ring_readers.store(true, std::memory_order_release);
+    for(size_t i = 0; i < CONFIG_ESP_BE_MAX_BUTTON_COUNT; i++) {
+      auto button = _buttons[i];
+      if(button && _owns(button)) {
+        _join_ring(button);
+      }
+    }
+    return EventRing::Reader(_ring, events);
+  }
+
+  void EventManager::join_ring(Button* button) {
+    if(_ring_readers.load(std::memory_order_acquire)) {
+      (button->_manager ? button->_manager : &instance())->_join_ring(button);
+    }
+  }
+
+  void EventManager::_join_ring(Button* button) {
+    auto events = _ring_events.load(std::memory_order_relaxed);
+    if(events) {
+      button->_allocate(events);
+      _subscribe(button, events);
+    }
+  }
+#endif
+
+  Hal::LoopHandle EventManager::_loop(const Button* button) const { return _loops[button->_index % _loops.size()]; }
+
+  HandlerHandle EventManager::add_event(Button* button, EventType event, esp_event_handler_t handler, void* arg) {
+    // Handlers are added from application tasks, the count is published once a new entry is filled. An entry removed
+    // from the same button and event is reused, since it is already registered with the event loop.
+    auto count = _handler_count.load(std::memory_order_acquire);
+    auto index = claim(_handlers, count, button, event);
+    auto reused = index < _handlers.size();
+    if(!reused) {
+      if(count >= _handlers.size()) {
+        ESP_LOGW(TAG, "Handler table full, %s event %d not added", button->_name, static_cast<int>(event));
+        return {};
+      }
+      index = count;
+    }
+    auto& entry = _handlers[index];
+    entry.handler.store(handler, std::memory_order_relaxed);
+    entry.arg.store(arg, std::memory_order_relaxed);
+#ifdef CONFIG_ESP_BE_HANDLER_WATCHDOG
+    for(auto counter: {&entry.calls, &entry.overruns, &entry.max_us}) {
+      counter->store(0, std::memory_order_relaxed);
+    }
+#endif
+    if(!reused) {
+      entry.manager = this;
+      entry.button = button;
+      entry.event = event;
+    }
+    auto generation = publish(entry);
+    if(!reused) {
+      _handler_count.store(index + 1, std::memory_order_release);
+      Hal::loop_register(_loop(button), BUTTON_EVENT, event_id(button->_index, event), _loop_handler, &entry);
+    }
+    _subscribe(button, event_mask(event));
+    _loop_subscriptions[button->_index].fetch_or(event_mask(event), std::memory_order_release);
+    return {this, static_cast<uint16_t>(index), generation, false};
+  }
+
+  HandlerHandle EventManager::add_inline_event(Button* button, EventType event, esp_event_handler_t handler, void* arg,
+                                               Hal::QueueHandle queue) {
+    // Subscribers are added from application tasks, the count is published once a new entry is filled.
+    auto count = _inline_count.load(std::memory_order_acquire);
+    auto index = claim(_inline, count, button, event);
+    auto reused = index < _inline.size();
+    if(!reused) {
+      if(count >= _inline.size()) {
+        return {};
+      }
+      index = count;
+    }
+    auto& entry = _inline[index];
+    entry.handler.store(handler, std::memory_order_relaxed);
+    entry.arg.store(arg, std::memory_order_relaxed);
+    entry.queue.store(queue, std::memory_order_relaxed);
+    if(!reused) {
+      entry.button = button;
+      entry.event = event;
+    }
+    auto generation = publish(entry);
+    if(!reused) {
+      _inline_count.store(index + 1, std::memory_order_release);
+    }
+    _subscribe(button, event_mask(event));
+    return {this, static_cast<uint16_t>(index), generation, true};
+  }
+
+  bool EventManager::remove_handler(const HandlerHandle& handle) {
+    auto remove = [&handle](auto& table, const size_t count) {
+      if(handle.index >= count) {
+        return false;
+      }
+      auto& entry = table[handle.index];
+      auto expected = EntryState::make(handle.generation, EntryState::active);
+      // The fields can't change while the entry is active, so they belong to the handler being removed.
+      auto handler = entry.handler.load(std::memory_order_relaxed);
+      auto arg = entry.arg.load(std::memory_order_relaxed);
+      if(!entry.state.compare_exchange_strong(expected, EntryState::make(handle.generation, 0), std::memory_order_acq_rel)) {
+        return false;
+      }
+      if(handler == Button::_typed_handler) {
+        Button::_release_handler(arg);
+      }
+      return true;
+    };
+    if(handle.inline_entry) {
+      return remove(_inline, _inline_count.load(std::memory_order_acquire));
+    }
+    return remove(_handlers, _handler_count.load(std::memory_order_acquire));
+  }
+
+  bool EventManager::add_subscription(const uint32_t buttons, const uint32_t events, esp_event_handler_t handler, void* arg) {
+    // Subscriptions are added from application tasks during setup, the count is published once the entry is filled.
+    auto index = _subscription_count.load(std::memory_order_relaxed);
+    if(index >= _subscription_table.size()) {
+      return false;
+    }
+    auto& entry = _subscription_table[index];
+    entry = {buttons, events, handler, arg};
+    _subscription_count.store(index + 1, std::memory_order_release);
+
+    uint32_t loops = 0;
+    for(size_t i = 0; i < CONFIG_ESP_BE_MAX_BUTTON_COUNT; i++) {
+      if(buttons & (1u << i)) {
+        _subscribe(_buttons[i], events);
+        _loop_subscriptions[i].fetch_or(events, std::memory_order_release);
+        loops |= 1u << (i % _loops.size());
+      }
+    }
+    for(size_t i = 0; i < _loops.size(); i++) {
+      if(loops & (1u << i)) {
+        Hal::loop_register(_loops[i], BUTTON_EVENT, ESP_EVENT_ANY_ID, _subscription_handler, &entry);
+      }
+    }
+    return true;
+  }
+
+  bool EventManager::add_batch_subscription(const uint32_t buttons, const uint32_t events, esp_event_handler_t handler, void* arg,
+                                            const uint32_t window_us) {
+    // Filled before the count is published, after which only the manager task touches the buffer and deadline.
+    auto index = _batch_count.load(std::memory_order_relaxed);
+    if(index >= _batches.size()) {
+      return false;
+    }
+    auto& entry = _batches[index];
+    entry.buttons = buttons;
+    entry.events = events;
+    entry.window_us = window_us;
+    entry.buffer.header = {};
+    Hal::loop_register(_loops[index % _loops.size()], BUTTON_BATCH_EVENT, static_cast<int32_t>(index), handler, arg);
+    _batch_count.store(index + 1, std::memory_order_release);
+
+    // Batched events are collected by the manager task, they are never posted one by one for the batch.
+    for(size_t i = 0; i < CONFIG_ESP_BE_MAX_BUTTON_COUNT; i++) {
+      if(buttons & (1u << i)) {
+        _subscribe(_buttons[i], events);
+      }
+    }
+    return true;
+  }
+
+  void EventManager::_batch(const EventRecord& record) {
+    auto count = _batch_count.load(std::memory_order_acquire);
+    for(size_t i = 0; i < count; i++) {
+      auto& entry = _batches[i];
+      if(!(entry.buttons & (1u << record.button)) || !(entry.events & event_mask(record.event))) {
+        continue;
+      }
+      auto& header = entry.buffer.header;
+      if(!header.count) {
+        entry.deadline = record.timestamp + entry.window_us;
+      }
+      entry.buffer.records[header.count++] = record;
+      if(header.count == entry.buffer.records.size()) {
+        _flush_batch(i);
+      }
+    }
+  }
+
+  void EventManager::_flush_batch(const size_t index) {
+    auto& buffer = _batches[index].buffer;
+    // The event loop copies the data, so the buffer is refilled straight away.
+    _post(_loops[index % _loops.size()], BUTTON_BATCH_EVENT, static_cast<int32_t>(index), &buffer,
+          sizeof(buffer.header) + buffer.header.count * sizeof(EventRecord));
+    buffer.header.count = 0;
+  }
+
+  void EventManager::_flush_batches(const uint64_t now) {
+    auto count = _batch_count.load(std::memory_order_acquire);
+    for(size_t i = 0; i < count; i++) {
+      if(_batches[i].buffer.header.count && _batches[i].deadline <= now) {
+        _flush_batch(i);
+      }
+    }
+  }
+
+  void EventManager::_subscription_handler(void* handler_args, esp_event_base_t base, int32_t id, void* event_data) {
+    auto& entry = *static_cast<const Subscription*>(handler_args);
+    auto event = EventView(event_data);
+    if((entry.buttons & (1u << event.index())) && (entry.events & event_mask(event.event()))) {
+      entry.handler(entry.arg, base, id, event_data);
+    }
+  }
+
+  template<typename entry_type>
+  bool EventManager::_enter(const entry_type& entry, const uint32_t state, const esp_event_handler_t handler, void* arg) {
+    if(handler != Button::_typed_handler) {
+      return true;
+    }
+    Button::_enter_handler(arg);
+    if(entry.state.load(std::memory_order_seq_cst) == state) {
+      return true;
+    }
+    Button::_exit_handler(arg);
+    return false;
+  }
+
+  void EventManager::_exit(const esp_event_handler_t handler, void* arg) {
+    if(handler == Button::_typed_handler) {
+      Button::_exit_handler(arg);
+    }
+  }
+
+  void EventManager::_send_inline(const Button* button, const EventRecord& record) {
+    auto count = _inline_count.load(std::memory_order_acquire);
+    for(size_t i = 0; i < count; i++) {
+      auto& s = _inline[i];
+      if(s.button != button || s.event != record.event) {
+        continue;
+      }
+      auto state = s.state.load(std::memory_order_acquire);
+      auto handler = s.handler.load(std::memory_order_relaxed);
+      auto arg = s.arg.load(std::memory_order_relaxed);
+      auto queue = s.queue.load(std::memory_order_relaxed);
+      if(!(state & EntryState::active) || !unchanged(s, state)) {
+        continue;
+      }
+      if(handler) {
+        if(!_enter(s, state, handler, arg)) {
+          continue;
+        }
+        // Handlers get a copy, as they would from the event loop.
+        auto copy = record;
+        handler(arg, BUTTON_EVENT, event_id(record.button, record.event), &copy);
+        _exit(handler, arg);
+      }
+      else if(!Hal::queue_send(queue, &record, 0)) {
+#ifdef CONFIG_ESP_BE_STATS
+        _stats.queue_drops.fetch_add(1, std::memory_order_relaxed);
+#endif
+      }
+    }
+  }
+
+  EventManager::EventManager(const ManagerConfig& config)
+      : _config(config),
+        _subscriptions{},
+        _loop_subscriptions{},
+        _inline{},
+        _inline_count(0),
+        _subscription_table{},
+        _subscription_count(0),
+        _batches{},
+        _batch_count(0),
+        _event_groups{},
+        _loops{},
+        _service{},
+        _handlers{},
+        _handler_count(0) {}
+
+  void EventManager::init() {
+    // The first use may come from several tasks at once, each waits until the manager is started.
+    std::call_once(_init_once, [this] { _start(); });
+  }
+
+  void EventManager::_start() {
+    Hal::TaskConfig task = {.name = _config.name,
+                            .stack_size = CONFIG_ESP_BE_TASK_STACK_SIZE,
+                            .priority = _config.priority,
+                            .core = _config.core,
+                            .buffer = nullptr,
+                            .stack = nullptr};
+
+    for(size_t i = 0; i < _event_groups.size(); i++) {
+#ifdef CONFIG_ESP_BE_STATIC_ALLOCATION
+      _event_groups[i] = Hal::signal_create(&_event_group_buffers[i]);
+#else
+      _event_groups[i] = Hal::signal_create(nullptr);
+#endif
+    }
+
+#ifdef CONFIG_ESP_BE_STATIC_ALLOCATION
+    task.buffer = &_task_buffer;
+    task.stack = _task_stack;
+#endif
+
+    // TODO need to be able to handle multiple sets of event loops to support more than (6) buttons.
+    _service = {.signal = _event_groups[0],
+                .mask = 0xFFFFFF,
+                .wake = [](void* arg, uint32_t bits) { static_cast<EventManager*>(arg)->_wake(bits); },
+                .timeout = [](void* arg) { return static_cast<EventManager*>(arg)->_wait_timeout(); },
+                .arg = this};
+    Hal::service_start(_service, task);
+
+    // TODO: Using default event loop vs dedicated
+#ifdef CONFIG_ESP_BE_SINGLE_TASK
+    // No task is created, the manager task runs the loop after each post.
+    _loops[0] = Hal::loop_create(nullptr, CONFIG_ESP_BE_EVENT_LOOP_QUEUE_SIZE);
+#else
+    for(size_t i = 0; i < _loops.size(); i++) {
+      Hal::TaskConfig loop_task = {.name = _config.loop_name,
+                                   .stack_size = CONFIG_ESP_BE_EVENT_LOOP_STACK_SIZE,
+                                   .priority = _config.loop_priority,
+                                   .core = _config.loop_core,
+                                   .buffer = nullptr,
+                                   .stack = nullptr};
+  #ifdef CONFIG_ESP_BE_EVENT_LOOP_SPREAD_CORES
+      loop_task.core = static_cast<int>(i % Hal::core_count());
+  #endif
+      _loops[i] = Hal::loop_create(&loop_task, CONFIG_ESP_BE_EVENT_LOOP_QUEUE_SIZE);
+    }
+#endif
+#if defined(CONFIG_ESP_BE_LATENCY_HISTOGRAMS) || defined(CONFIG_ESP_BE_STATS) || defined(CONFIG_ESP_BE_HOOKS)
+    for(auto loop: _loops) {
+  #ifdef CONFIG_ESP_BE_LATENCY_HISTOGRAMS
+      // Handlers for any base run first, so this marks handler entry for every event.
+      Hal::loop_register(loop, ESP_EVENT_ANY_BASE, ESP_EVENT_ANY_ID, _latency_handler, nullptr);
+  #endif
+  #ifdef CONFIG_ESP_BE_STATS
+      Hal::loop_register(loop, ESP_EVENT_ANY_BASE, ESP_EVENT_ANY_ID, _stats_handler, this);
+  #endif
+  #ifdef CONFIG_ESP_BE_HOOKS
+      Hal::loop_register(loop, ESP_EVENT_ANY_BASE, ESP_EVENT_ANY_ID, _hooks_handler, nullptr);
+  #endif
+    }
+#endif
   };
 
-  void EventManager::_send_event(Button* button, EventType event) {
-    auto e = EventData();
-    e.button = button;
-    e.timestamp = esp_timer_get_time();
-    e.event = event;
-    esp_event_post_to(loop_with_task, button->_name, static_cast<uint32_t>(event), &e, sizeof(e), portMAX_DELAY);
+  void EventManager::_send_event(Button* button, EventType event, const uint64_t duration_us, const uint8_t repeat) {
+    if(!_subscribed(button, event)) {
+      return;
+    }
+    EventRecord record = {.timestamp = Hal::time_us(),
+                          .duration_us = static_cast<uint32_t>(std::min<uint64_t>(duration_us, UINT32_MAX)),
+                          .button = static_cast<uint8_t>(button->_index),
+                          .event = event,
+                          .sequence = button->_sequence[static_cast<size_t>(event)]++,
+                          .repeat = repeat};
+#ifdef CONFIG_ESP_BE_TRACE
+    Trace::record_event(button->_index, event);
+#endif
+#ifdef CONFIG_ESP_BE_LATENCY_HISTOGRAMS
+    Latency::posted(button->_index, event, record.timestamp);
+#endif
+    Hooks::emit(Hooks::Point::POST, button->_index, static_cast<uint8_t>(event));
+#ifdef CONFIG_ESP_BE_STATS
+    _stats.posted[static_cast<size_t>(event)].fetch_add(1, std::memory_order_relaxed);
+#endif
+    _send_inline(button, record);
+    _batch(record);
+#ifdef CONFIG_ESP_BE_EVENT_RING
+    if(_ring_events.load(std::memory_order_relaxed) & event_mask(event)) {
+      _ring.publish(record);
+    }
+#endif
+    if(_loop_subscriptions[button->_index].load(std::memory_order_acquire) & event_mask(event)) {
+      _post(_loop(button), BUTTON_EVENT, event_id(record.button, record.event), &record, sizeof(record));
+    }
+#if ESP_BE_COROUTINES
+    _waiters.notify(button, static_cast<size_t>(event), EventData(&record));
+#endif
+  }
+
+  void EventManager::_post(Hal::LoopHandle loop, esp_event_base_t base, const int32_t id, const void* data, const size_t size) {
+#ifdef CONFIG_ESP_BE_STATS
+    // Counted before posting, since in single task mode the event is dispatched before the post returns.
+    auto in_flight = _stats.in_flight.fetch_add(1, std::memory_order_relaxed) + 1;
+    _stats.queue_high_watermark.store(std::max(_stats.queue_high_watermark.load(std::memory_order_relaxed), in_flight),
+                                      std::memory_order_relaxed);
+#endif
+#ifdef CONFIG_ESP_BE_SINGLE_TASK
+    // The queue is drained after every post, so there is always space and the post never blocks.
+    Hal::loop_post(loop, base, id, data, size, 0);
+    Hal::loop_run(loop);
+#elif defined(CONFIG_ESP_BE_STATS)
+    // A post which can't complete immediately is counted as blocked, along with the time it waits for space.
+    if(!Hal::loop_post(loop, base, id, data, size, 0)) {
+      auto start = Hal::time_us();
+      Hal::loop_post(loop, base, id, data, size, Hal::wait_forever());
+      auto blocked_us = static_cast<uint32_t>(Hal::time_us() - start);
+      _stats.blocked_posts.fetch_add(1, std::memory_order_relaxed);
+      _stats.blocked_us.fetch_add(blocked_us, std::memory_order_relaxed);
+      _stats.max_blocked_us.store(std::max(_stats.max_blocked_us.load(std::memory_order_relaxed), blocked_us),
+                                  std::memory_order_relaxed);
+    }
+#else
+    Hal::loop_post(loop, base, id, data, size, Hal::wait_forever());
+#endif
+  }
+
+#ifdef CONFIG_ESP_BE_LATENCY_HISTOGRAMS
+  void EventManager::_latency_handler(void* handler_args, esp_event_base_t base, int32_t id, void* event_data) {
+    if(base != BUTTON_EVENT) {
+      return;
+    }
+    auto event = EventView(event_data);
+    Latency::entered(event.index(), event.event(), event.timestamp());
+  }
+#endif
+
+#ifdef CONFIG_ESP_BE_STATS
+  void EventManager::_stats_handler(void* handler_args, esp_event_base_t base, int32_t id, void* event_data) {
+    auto& stats = static_cast<EventManager*>(handler_args)->_stats;
+    stats.in_flight.fetch_sub(1, std::memory_order_relaxed);
+    stats.loop_stack_free.store(Hal::task_stack_free(), std::memory_order_relaxed);
+  }
+
+  Stats EventManager::stats() {
+    Stats s = {};
+    s.wakes = _stats.wakes.load(std::memory_order_relaxed);
+    s.decoded = _stats.decoded.load(std::memory_order_relaxed);
+    s.max_decoded_per_wake = _stats.max_decoded_per_wake.load(std::memory_order_relaxed);
+    for(size_t i = 0; i < event_type_count; i++) {
+      s.posted[i] = _stats.posted[i].load(std::memory_order_relaxed);
+    }
+    s.blocked_posts = _stats.blocked_posts.load(std::memory_order_relaxed);
+    s.blocked_us = _stats.blocked_us.load(std::memory_order_relaxed);
+    s.max_blocked_us = _stats.max_blocked_us.load(std::memory_order_relaxed);
+    s.queue_high_watermark = _stats.queue_high_watermark.load(std::memory_order_relaxed);
+    s.queue_drops = _stats.queue_drops.load(std::memory_order_relaxed);
+    s.manager_stack_free = _stats.manager_stack_free.load(std::memory_order_relaxed);
+    s.loop_stack_free = _stats.loop_stack_free.load(std::memory_order_relaxed);
+    // Buttons of all managers share the button table.
+    for(size_t i = 0; i < s.buttons.size(); i++) {
+      if(auto button = _buttons[i]; button && _owns(button)) {
+        s.buttons[i] = {button, button->_edges.load(std::memory_order_relaxed), button->_spurious.load(std::memory_order_relaxed)};
+      }
+    }
+    return s;
+  }
+
+  void EventManager::reset_stats() {
+    for(auto counter: {&_stats.wakes, &_stats.decoded, &_stats.max_decoded_per_wake, &_stats.blocked_posts, &_stats.max_blocked_us,
+                       &_stats.queue_high_watermark, &_stats.queue_drops}) {
+      counter->store(0, std::memory_order_relaxed);
+    }
+    for(auto& counter: _stats.posted) {
+      counter.store(0, std::memory_order_relaxed);
+    }
+    _stats.blocked_us.store(0, std::memory_order_relaxed);
+    for(size_t i = 0; i < CONFIG_ESP_BE_MAX_BUTTON_COUNT; i++) {
+      if(auto button = _buttons[i]; button && _owns(button)) {
+        button->_edges.store(0, std::memory_order_relaxed);
+        button->_spurious.store(0, std::memory_order_relaxed);
+      }
+    }
+  }
+#endif
+
+  void EventManager::_loop_handler(void* handler_args, esp_event_base_t base, int32_t id, void* event_data) {
+    auto& entry = *static_cast<LoopHandler*>(handler_args);
+    auto state = entry.state.load(std::memory_order_acquire);
+    auto handler = entry.handler.load(std::memory_order_relaxed);
+    auto arg = entry.arg.load(std::memory_order_relaxed);
+    if(!(state & EntryState::active) || !unchanged(entry, state) || !_enter(entry, state, handler, arg)) {
+      return;
+    }
+#ifndef CONFIG_ESP_BE_HANDLER_WATCHDOG
+    handler(arg, base, id, event_data);
+    _exit(handler, arg);
+#else
+    auto start = Hal::time_us();
+    handler(arg, base, id, event_data);
+    auto duration_us = static_cast<uint32_t>(Hal::time_us() - start);
+    _exit(handler, arg);
+
+    auto& manager = *entry.manager;
+    entry.calls.fetch_add(1, std::memory_order_relaxed);
+    entry.max_us.store(std::max(entry.max_us.load(std::memory_order_relaxed), duration_us), std::memory_order_relaxed);
+    auto budget_us = manager._budget_us.load(std::memory_order_relaxed);
+    if(duration_us <= budget_us) {
+      return;
+    }
+    entry.overruns.fetch_add(1, std::memory_order_relaxed);
+    ESP_LOGW(TAG, "Handler %p of %s event %d ran for %u us, budget %u us", reinterpret_cast<void*>(handler), entry.button->_name,
+             static_cast<int>(entry.event), static_cast<unsigned>(duration_us), static_cast<unsigned>(budget_us));
+    // The callback is read again after its argument, a change in between may have paired it with another argument.
+    auto callback = manager._overrun_callback.load(std::memory_order_acquire);
+    auto callback_arg = manager._overrun_arg.load(std::memory_order_acquire);
+    if(callback && callback == manager._overrun_callback.load(std::memory_order_relaxed)) {
+      callback({entry.button, entry.event, handler, arg, duration_us, budget_us}, callback_arg);
+    }
+#endif
+  }
+
+#ifdef CONFIG_ESP_BE_HANDLER_WATCHDOG
+  void EventManager::set_handler_budget_us(const uint32_t budget_us) { _budget_us.store(budget_us, std::memory_order_relaxed); }
+
+  void EventManager::set_overrun_callback(Watchdog::Callback callback, void* arg) {
+    // Cleared first, so a reader which sees the new argument sees the callback change.
+    _overrun_callback.store(nullptr, std::memory_order_release);
+    _overrun_arg.store(arg, std::memory_order_release);
+    _overrun_callback.store(callback, std::memory_order_release);
+  }
+
+  size_t EventManager::handler_count() const { return _handler_count.load(std::memory_order_acquire); }
+
+  Watchdog::HandlerStats EventManager::handler_stats(const size_t index) const {
+    auto& entry = _handlers[index];
+    return {entry.button, entry.event, entry.handler.load(std::memory_order_relaxed), entry.calls.load(std::memory_order_relaxed),
+            entry.overruns.load(std::memory_order_relaxed), entry.max_us.load(std::memory_order_relaxed)};
+  }
+#endif
+
+#ifdef CONFIG_ESP_BE_HOOKS
+  void EventManager::_hooks_handler(void* handler_args, esp_event_base_t base, int32_t id, void* event_data) {
+    if(base != BUTTON_EVENT) {
+      return;
+    }
+    auto event = EventView(event_data);
+    Hooks::emit(Hooks::Point::DISPATCH, event.index(), static_cast<uint8_t>(event.event()));
   }
+#endif
 
-  void EventManager::task_loop() {
+  void EventManager::_wake(uint32_t bits) {
     // TODO: Refactor me. Have an event to handler mapping, rather than if, else if.
-    while(true) {
-      // TODO need to be able to handle multiple sets of event loops to support more than (6) buttons.
-      EventBits_t bits = xEventGroupWaitBits(_event_groups[0], 0xFFFFFF, pdTRUE, pdFALSE, portMAX_DELAY);
-
-      auto events = EventBit::Generator(bits);
-      for(const auto& event: events) {
-        auto button = _buttons[event.button];
-        if(event.trigger == Trigger::PRESS_EVENT) {
-          if(!button->_debounce_active) {
-            button->_debounce_active = true;
-            esp_timer_start_once(button->_debounce_timer, button->_debounce);
+#if ESP_BE_COROUTINES
+    _waiters.expire(Hal::time_us());
+#endif
+    bits &= ~wake_bit();
+    Hooks::emit(Hooks::Point::WAKE_BEGIN, Hooks::no_button, __builtin_popcount(bits));
+
+    auto events = EventBit::Generator(bits);
+#ifdef CONFIG_ESP_BE_STATS
+    // Each set bit is one button trigger.
+    auto decoded = static_cast<uint32_t>(__builtin_popcount(bits));
+    _stats.wakes.fetch_add(1, std::memory_order_relaxed);
+    _stats.decoded.fetch_add(decoded, std::memory_order_relaxed);
+    _stats.max_decoded_per_wake.store(std::max(_stats.max_decoded_per_wake.load(std::memory_order_relaxed), decoded),
+                                      std::memory_order_relaxed);
+    _stats.manager_stack_free.store(Hal::task_stack_free(), std::memory_order_relaxed);
+#endif
+    for(const auto& event: events) {
+      auto button = _buttons[event.button];
+      Hooks::emit(Hooks::Point::DECODE, button->_index, event.trigger);
+      if(event.trigger == Trigger::PRESS_EVENT) {
+        if(!button->_debounce_active) {
+          button->_debounce_active = true;
+          Hal::timer_start_once(button->_debounce_timer, button->_debounce);
+        }
+      }
+
+      if(event.trigger == Trigger::TIMER_EVENT) {
+#ifdef CONFIG_ESP_BE_LATENCY_HISTOGRAMS
+        Latency::classified(button->_index);
+#endif
+        button->_debounce_active = false;
+#ifdef CONFIG_ESP_BE_STATS
+        if(button->_current_state == button->_reported_state) {
+          button->_spurious.fetch_add(1, std::memory_order_relaxed);
+        }
+        button->_reported_state = button->_current_state;
+#endif
+        if(button->_current_state == State::PRESSED) {
+          button->_transition_time = Hal::time_us();
+          button->_held_count = 0;
+          if(_subscribed(button, EventType::BUTTON_HELD)) {
+            Hal::timer_start_once(button->_held_timer, button->_hold_press);
           }
+          _send_event(button, EventType::BUTTON_DOWN);
         }
+        else {
+          auto current_time = Hal::time_us();
+          auto delta_us = (current_time - button->_transition_time);
+          if(button->_held_timer) {
+            Hal::timer_stop(button->_held_timer);
+          }
+          _send_event(button, EventType::BUTTON_UP, delta_us);
 
-        if(event.trigger == Trigger::TIMER_EVENT) {
-          button->_debounce_active = false;
-          if(button->_current_state == State::PRESSED) {
-            button->_transition_time = esp_timer_get_time();
-            esp_timer_start_once(button->_held_timer, button->_hold_press);
-            // TODO: Kconfig to disable transition events
-            _send_event(button, EventType::BUTTON_DOWN);
+          if(delta_us > button->_long_press) {
+            _send_event(button, EventType::BUTTON_LONG_PRESS, delta_us);
+          }
+          else if(delta_us > button->_short_press) {
+            _send_event(button, EventType::BUTTON_PRESS, delta_us);
           }
           else {
-            auto current_time = esp_timer_get_time();
-            auto delta_us = (current_time - button->_transition_time);
-            esp_timer_stop(button->_held_timer);
-            // TODO: Kconfig to disable transition events
-            _send_event(button, EventType::BUTTON_UP);
-
-            if(delta_us > button->_long_press) {
-              _send_event(button, EventType::BUTTON_LONG_PRESS);
-            }
-            else if(delta_us > button->_short_press) {
-              _send_event(button, EventType::BUTTON_PRESS);
-            }
-            else {
-              // No press
-            }
+            // No press
           }
         }
-        if(event.trigger == Trigger::REPEAT_EVENT) {
-          // TODO, maybe make repeat events selectable.
-          _send_event(button, EventType::BUTTON_HELD);
-        }
+      }
+      if(event.trigger == Trigger::REPEAT_EVENT) {
+        // TODO, maybe make repeat events selectable.
+        auto repeat = button->_held_count;
+        button->_held_count += repeat < UINT8_MAX;
+        _send_event(button, EventType::BUTTON_HELD, Hal::time_us() - button->_transition_time, repeat);
       }
     }
+    _flush_batches(Hal::time_us());
+    Hooks::emit(Hooks::Point::WAKE_END, Hooks::no_button);
   }
 };  // namespace ButtonEvents
\ No newline at end of file
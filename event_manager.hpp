@@ -1,12 +1,16 @@
 #pragma once
 
+#include <atomic>
 #include <cstddef>
+#include <mutex>
 #include <esp_idf_button_events/button.hpp>
+#include <esp_idf_button_events/ring.hpp>
+#include <esp_idf_button_events/stats.hpp>
+#include <esp_idf_button_events/watchdog.hpp>
 
 #include "button_storage.hpp"
-#include "esp_event.h"
-#include "esp_event_base.h"
 #include "event_bits.hpp"
+#include "hal.hpp"
 
 namespace ButtonEvents {
   /**
@@ -15,51 +19,369 @@ namespace ButtonEvents {
    */
   constexpr size_t event_group_count() { return (CONFIG_ESP_BE_MAX_BUTTON_COUNT / EventBit::buttons_per_group()) + 1; }
 
+  /**
+   * @brief Gets the number of event loops handlers are dispatched from. Each button is assigned to one loop, so its
+   *        events stay in order, while the handlers of buttons on different loops run in parallel.
+   * @return constexpr size_t Event loop count.
+   */
+#ifdef CONFIG_ESP_BE_SINGLE_TASK
+  constexpr size_t event_loop_count() { return 1; }
+#else
+  constexpr size_t event_loop_count() { return CONFIG_ESP_BE_EVENT_LOOP_COUNT; }
+#endif
+
+  /**
+   * @brief State of a handler table entry. Bit 0 is set while the entry is active, bit 1 while it is being rewritten
+   *        for reuse, and bits 17-2 hold its generation, incremented on each reuse.
+   * @details Dispatch reads the state before and after the handler fields, and skips the entry if it changed, so a
+   * removal or reuse racing with dispatch never calls a mix of old and new fields.
+   */
+  namespace EntryState {
+    constexpr uint32_t active = 1 << 0;
+    constexpr uint32_t busy = 1 << 1;
+    constexpr uint16_t generation(const uint32_t state) { return static_cast<uint16_t>(state >> 2); }
+    constexpr uint32_t make(const uint16_t generation, const uint32_t flags) { return (static_cast<uint32_t>(generation) << 2) | flags; }
+  }  // namespace EntryState
+
   /**
    * @brief Internally used component class for managing button events and propogating them to subscribers.
    */
   class EventManager {
    public:
     /**
-     * @brief Get the singleton class instance. The event manager is initialised the first time this is called.
+     * @brief Get the default event manager. The event manager is initialised the first time this is called.
      * @return EventManager&
      */
     static EventManager& instance();
     /**
-     * @brief Add a button to be managed by the event manager. Buttons are referenced by their storage address.
-     *        Duplicate additions of the same address are ignored.
+     * @brief Create and initialise an additional event manager.
+     * @param config The task configuration.
+     * @return EventManager*
+     */
+    static EventManager* create(const ManagerConfig& config);
+    /**
+     * @brief Create the event manager task, event groups and event loop. Calling this more than once has no effect.
+     * @details Called by instance() if it hasn't been called yet. Concurrent callers block until the first call has
+     *          finished. Applications needing deterministic boot should call ButtonEvents::init() before creating
+     *          buttons.
+     */
+    void init();
+    /**
+     * @brief Add a button to the registry shared by all event managers, which assigns each button a unique index.
+     *        Buttons are referenced by their storage address. Duplicate additions of the same address are ignored.
      * @param button The button to add.
-     * @return Storage::Binding Parameters used to set the button's binding to the event manager.
+     * @return Storage::Binding Parameters used to set the button's binding to an event manager.
      */
-    Storage::Binding add_button(Button* button);
+    static Storage::Binding add_button(Button* button);
+
+    /**
+     * @brief Get a button from the registry by its index.
+     * @param index The button index.
+     * @return Button* The button, or nullptr if there is no button with the index.
+     */
+    static Button* button(const size_t index);
 
     /**
      * @brief Connects an event for a button to a handler.
+     * @details The event is marked as subscribed for the button. Events without subscribers are not posted.
      *
      * @param button The button to which the event is tied.
      * @param event  The type of event.
      * @param handler The handler called when the event occurs.
      * @param arg An argument passed to the event handler.
+     * @return HandlerHandle The handle of the handler, empty if the handler table is full.
+     */
+    HandlerHandle add_event(Button* button, EventType event, esp_event_handler_t handler, void* arg);
+
+    /**
+     * @brief Connects an event for a button to a handler called, or a queue sent to, from the event manager task.
+     * @details Additions beyond CONFIG_ESP_BE_MAX_INLINE_SUBSCRIBERS are ignored.
+     *
+     * @param button The button to which the event is tied.
+     * @param event The type of event.
+     * @param handler The handler called when the event occurs, or nullptr when sending to a queue.
+     * @param arg An argument passed to the event handler.
+     * @param queue The queue the event data is sent to, or nullptr when calling a handler.
+     * @return HandlerHandle The handle of the subscriber, empty if the inline table is full.
      */
-    void add_event(Button* button, EventType event, esp_event_handler_t handler, void* arg);
+    HandlerHandle add_inline_event(Button* button, EventType event, esp_event_handler_t handler, void* arg, Hal::QueueHandle queue);
+
+    /**
+     * @brief Remove a handler or queue. The table entry is marked as removed, and reused by the next addition for
+     *        the same button and event. Events stay subscribed, since other handlers may remain.
+     * @param handle The handle returned when the handler was added.
+     * @return true The handler was removed.
+     * @return false The handler was already removed.
+     */
+    bool remove_handler(const HandlerHandle& handle);
+
+    /**
+     * @brief Connects a set of events on a set of buttons to a handler, registered once on each event loop serving
+     *        the buttons and matched at dispatch.
+     * @param buttons A mask of the button indices.
+     * @param events A mask of the events.
+     * @param handler The handler called when an event in the set occurs.
+     * @param arg An argument passed to the event handler.
+     * @return true The subscription was added.
+     * @return false The subscription table is full.
+     */
+    bool add_subscription(const uint32_t buttons, const uint32_t events, esp_event_handler_t handler, void* arg);
+
+    /**
+     * @brief Connects a set of events on a set of buttons to a handler called with batches of events. The handler is
+     *        registered for BUTTON_BATCH_EVENT with the index of the batch as the event id.
+     * @param buttons A mask of the button indices.
+     * @param events A mask of the events.
+     * @param handler The handler called with each batch.
+     * @param arg An argument passed to the event handler.
+     * @param window_us Time from the first event of a batch to posting it, 0 to post at the end of each wake.
+     * @return true The subscription was added.
+     * @return false The batch table is full.
+     */
+    bool add_batch_subscription(const uint32_t buttons, const uint32_t events, esp_event_handler_t handler, void* arg,
+                                const uint32_t window_us);
 
     /**
      * @brief Get the event group handler at a given index.
      * @param index The index to fetch.
-     * @return EventGroupHandle_t
+     * @return Hal::SignalHandle
+     */
+    Hal::SignalHandle event_group(const size_t index);
+
+#ifdef CONFIG_ESP_BE_STATS
+    /**
+     * @brief Get a snapshot of the runtime statistics.
+     * @return Stats
+     */
+    Stats stats();
+
+    /**
+     * @brief Reset the runtime statistics. Stack high watermarks are not reset.
      */
-    EventGroupHandle_t event_group(const size_t index);
+    void reset_stats();
+#endif
+
+#ifdef CONFIG_ESP_BE_HANDLER_WATCHDOG
+    /**
+     * @brief Set the handler execution time budget.
+     * @param budget_us The budget in us.
+     */
+    void set_handler_budget_us(const uint32_t budget_us);
+
+    /**
+     * @brief Set the callback called on each handler overrun. Safe to call while handlers run, an overrun racing with
+     *        the change is passed to neither callback, or to one with its own argument.
+     * @param callback The callback, or nullptr for none.
+     * @param arg An argument passed to the callback.
+     */
+    void set_overrun_callback(Watchdog::Callback callback, void* arg);
+
+    /**
+     * @brief Get the number of timed handlers.
+     * @return size_t
+     */
+    size_t handler_count() const;
+
+    /**
+     * @brief Get the timing statistics of a handler.
+     * @param index The handler index, less than handler_count().
+     * @return Watchdog::HandlerStats
+     */
+    Watchdog::HandlerStats handler_stats(const size_t index) const;
+#endif
+
+#ifdef CONFIG_ESP_BE_EVENT_RING
+    /**
+     * @brief Add events to those written to the event ring for the buttons of this manager, and get a reader of the
+     *        ring.
+     * @param events A mask of the events.
+     * @return EventRing::Reader A reader of the events, starting at the next event.
+     */
+    EventRing::Reader ring_reader(const uint32_t events);
+
+    /**
+     * @brief Write the events of the ring readers of a button's manager to the ring, if any manager has ring readers.
+     * @details Called once the button is built, so buttons created after a reader are covered too. The default manager
+     * is only created if it has readers.
+     * @param button The button.
+     */
+    static void join_ring(Button* button);
+#endif
+
+#if ESP_BE_COROUTINES
+    /**
+     * @brief Add a coroutine waiting for a button event. The coroutine is resumed from the manager task.
+     * @details Matches Coroutine::Awaitable::add_function, so it can be handed directly to awaitables.
+     * @param manager The event manager to wait on.
+     * @param waiter The waiter, stored in the suspended coroutine frame.
+     */
+    static void add_waiter(void* manager, Coroutine::Waiter<EventData>& waiter);
+#endif
 
    private:
-    EventManager();
-    void task_loop();
-    Storage::ButtonHandler<Button*, CONFIG_ESP_BE_MAX_BUTTON_COUNT, EventBit::buttons_per_group()> _buttons;
-    void _send_event(Button* button, EventType event);
+    explicit EventManager(const ManagerConfig& config);
+    void _wake(uint32_t bits);
+#ifdef CONFIG_ESP_BE_LATENCY_HISTOGRAMS
+    static void _latency_handler(void* handler_args, esp_event_base_t base, int32_t id, void* event_data);
+#endif
+#ifdef CONFIG_ESP_BE_HOOKS
+    static void _hooks_handler(void* handler_args, esp_event_base_t base, int32_t id, void* event_data);
+#endif
+    static void _subscription_handler(void* handler_args, esp_event_base_t base, int32_t id, void* event_data);
+    static void _loop_handler(void* handler_args, esp_event_base_t base, int32_t id, void* event_data);
+#ifdef CONFIG_ESP_BE_STATS
+    static void _stats_handler(void* handler_args, esp_event_base_t base, int32_t id, void* event_data);
+#endif
+    uint64_t _wait_timeout();
+    void _start();
+    std::once_flag _init_once;
+    ManagerConfig _config;
+    // Buttons of all managers, so indices are unique. A manager only receives the trigger bits of its own buttons.
+    static inline Storage::ButtonHandler<Button*, CONFIG_ESP_BE_MAX_BUTTON_COUNT, EventBit::buttons_per_group()> _buttons;
+    void _send_event(Button* button, EventType event, const uint64_t duration_us = 0, const uint8_t repeat = 0);
+    void _post(Hal::LoopHandle loop, esp_event_base_t base, const int32_t id, const void* data, const size_t size);
+    void _batch(const EventRecord& record);
+    void _flush_batch(const size_t index);
+    void _flush_batches(const uint64_t now);
+    bool _owns(const Button* button);
+    void _subscribe(const Button* button, const uint32_t mask);
+    bool _subscribed(const Button* button, const EventType event) const;
+    void _send_inline(const Button* button, const EventRecord& record);
+    /**
+     * @brief Mark a typed handler as running before it is called, so its callable isn't reused if it's removed.
+     * @details The entry is checked again once marked. If it was removed before then, the handler is skipped.
+     * @return true The handler can be called, and _exit() must be called once it returns.
+     */
+    template<typename entry_type>
+    static bool _enter(const entry_type& entry, const uint32_t state, const esp_event_handler_t handler, void* arg);
+    static void _exit(const esp_event_handler_t handler, void* arg);
+    Hal::LoopHandle _loop(const Button* button) const;
+
+    std::array<std::atomic<uint8_t>, CONFIG_ESP_BE_MAX_BUTTON_COUNT> _subscriptions;
+    std::array<std::atomic<uint8_t>, CONFIG_ESP_BE_MAX_BUTTON_COUNT> _loop_subscriptions;
+
+    /**
+     * @brief A handler or queue called from the event manager task. The button and event are fixed once the entry is
+     *        published, the remaining fields are rewritten when the entry is reused. See EntryState.
+     */
+    struct InlineSubscriber {
+      const Button* button;
+      EventType event;
+      std::atomic<esp_event_handler_t> handler;
+      std::atomic<void*> arg;
+      std::atomic<Hal::QueueHandle> queue;
+      std::atomic<uint32_t> state;
+    };
+    std::array<InlineSubscriber, CONFIG_ESP_BE_MAX_INLINE_SUBSCRIBERS> _inline;
+    std::atomic<size_t> _inline_count;
+
+    /**
+     * @brief A handler for a set of events on a set of buttons, registered with the event loops behind
+     *        _subscription_handler.
+     */
+    struct Subscription {
+      uint32_t buttons;
+      uint32_t events;
+      esp_event_handler_t handler;
+      void* arg;
+    };
+    std::array<Subscription, CONFIG_ESP_BE_MAX_SUBSCRIPTIONS> _subscription_table;
+    std::atomic<size_t> _subscription_count;
+
+    /**
+     * @brief Events collected for a batch handler. The buttons, events and window are fixed once the entry is
+     *        published, the deadline and buffer are only accessed from the event manager task.
+     */
+    struct BatchSubscriber {
+      uint32_t buttons;
+      uint32_t events;
+      uint32_t window_us;
+      uint64_t deadline;
+      struct Buffer {
+        EventBatch::Header header;
+        std::array<EventRecord, CONFIG_ESP_BE_BATCH_CAPACITY> records;
+      } buffer;
+    };
+    std::array<BatchSubscriber, CONFIG_ESP_BE_MAX_BATCH_SUBSCRIBERS> _batches;
+    std::atomic<size_t> _batch_count;
+    std::array<Hal::SignalHandle, event_group_count()> _event_groups;
+    std::array<Hal::LoopHandle, event_loop_count()> _loops;
+    Hal::Service _service;
+
+#ifdef CONFIG_ESP_BE_STATIC_ALLOCATION
+    std::array<Hal::SignalBuffer, event_group_count()> _event_group_buffers;
+    Hal::TaskBuffer _task_buffer;
+    Hal::StackWord _task_stack[CONFIG_ESP_BE_TASK_STACK_SIZE];
+#endif
+
+#if ESP_BE_COROUTINES
+    Coroutine::WaitList<EventData, Hal::CriticalSection> _waiters;
+#endif
 
-    std::array<EventGroupHandle_t, event_group_count()> _event_groups;
-    esp_event_loop_handle_t loop_with_task;
+#ifdef CONFIG_ESP_BE_EVENT_RING
+    EventRing _ring;
+    std::atomic<uint32_t> _ring_events = 0;
+    static inline std::atomic<bool> _ring_readers = false;
+    void _join_ring(Button* button);
+#endif
+
+#ifdef CONFIG_ESP_BE_STATS
+    /**
+     * @brief Manager counters. Maximums are only written by a single task, so need no compare and swap.
+     */
+    struct Counters {
+      std::atomic<uint32_t> wakes;
+      std::atomic<uint32_t> decoded;
+      std::atomic<uint32_t> max_decoded_per_wake;
+      std::array<std::atomic<uint32_t>, event_type_count> posted;
+      std::atomic<uint32_t> blocked_posts;
+      std::atomic<uint64_t> blocked_us;
+      std::atomic<uint32_t> max_blocked_us;
+      std::atomic<uint32_t> in_flight;
+      std::atomic<uint32_t> queue_high_watermark;
+      std::atomic<uint32_t> queue_drops;
+      std::atomic<uint32_t> manager_stack_free;
+      std::atomic<uint32_t> loop_stack_free;
+    };
+    Counters _stats;
+#endif
+
+    /**
+     * @brief A user handler, registered with the event loop of its button behind _loop_handler. The button and event
+     *        are fixed once the entry is published, the handler and argument are rewritten when the entry is reused.
+     *        Counters are only written by the event loop task.
+     */
+    struct LoopHandler {
+      EventManager* manager;
+      Button* button;
+      EventType event;
+      std::atomic<esp_event_handler_t> handler;
+      std::atomic<void*> arg;
+      std::atomic<uint32_t> state;
+#ifdef CONFIG_ESP_BE_HANDLER_WATCHDOG
+      std::atomic<uint32_t> calls;
+      std::atomic<uint32_t> overruns;
+      std::atomic<uint32_t> max_us;
+#endif
+    };
+    std::array<LoopHandler, CONFIG_ESP_BE_MAX_HANDLERS> _handlers;
+    std::atomic<size_t> _handler_count;
+
+#ifdef CONFIG_ESP_BE_HANDLER_WATCHDOG
+    // Initialised here, so the constructor is the same with and without the watchdog.
+    std::atomic<uint32_t> _budget_us = CONFIG_ESP_BE_HANDLER_BUDGET_US;
+    std::atomic<Watchdog::Callback> _overrun_callback = nullptr;
+    std::atomic<void*> _overrun_arg = nullptr;
+#endif
   };
 
+  /**
+   * @brief Event bit used to wake the manager task without a button event, e.g. when a new wait deadline is added.
+   *        Uses the trigger bits of the last button in the first group, which is never assigned.
+   */
+  constexpr uint32_t wake_bit() { return EventBit::get_bit_mask(EventBit::Trigger::REPEAT_EVENT, EventBit::buttons_per_group() - 1); }
+  static_assert(CONFIG_ESP_BE_MAX_BUTTON_COUNT < EventBit::buttons_per_group(), "The manager wake bit overlaps a button.");
+
   // TODO support more buttons.
   static_assert(CONFIG_ESP_BE_MAX_BUTTON_COUNT <= 6, "No support for more than six buttons. Event groups need additions.");
 
@@ -14,28 +14,44 @@ using namespace ButtonEvents;
 // Specify a dummy class to demonstrate calling a class member on event handler.
 class Object {
  public:
-  void handler() { ESP_LOGI(LOG_TAG, "Class handler called"); }
+  void handler(EventView event) { ESP_LOGI(LOG_TAG, "Class handler called: %s", event.button()->name()); }
 };
 
 // Three event handlers which are called on button events.
 static void press_any(void* handler_args, esp_event_base_t base, int32_t id, void* event_data) {
-  auto event = EventData(event_data);
+  auto event = EventView(event_data);
 
   // This would need to be handled better if the argument type was unknown.
   auto arg = static_cast<int*>(handler_args);
-  ESP_LOGI(LOG_TAG, "Any handler: %s: ID %li, arg: %d", event.button->name(), id, *arg);
+  ESP_LOGI(LOG_TAG, "Any handler: %s: ID %d, arg: %d", event.button()->name(), static_cast<int>(event.event()), *arg);
 }
 
 static void press_handler(void* handler_args, esp_event_base_t base, int32_t id, void* event_data) {
-  auto event = EventData(event_data);
-  ESP_LOGI(LOG_TAG, "Press handler: %s: ID %li", event.button->name(), id);
+  auto event = EventView(event_data);
+  ESP_LOGI(LOG_TAG, "Press handler: %s: ID %d", event.button()->name(), static_cast<int>(event.event()));
 }
 
 static void long_handler(void* handler_args, esp_event_base_t base, int32_t id, void* event_data) {
-  auto event = EventData(event_data);
-  ESP_LOGI(LOG_TAG, "Long handler: %s: ID %li", event.button->name(), id);
+  auto event = EventView(event_data);
+  ESP_LOGI(LOG_TAG, "Long handler: %s: ID %d", event.button()->name(), static_cast<int>(event.event()));
 }
 
+#if ESP_BE_COROUTINES
+// A UI flow written as a coroutine. Press, then long press within 2s to confirm.
+static Coroutine::Task confirm_flow(Button* button) {
+  while(true) {
+    co_await button->next(EventType::BUTTON_PRESS);
+    ESP_LOGI(LOG_TAG, "Long press %s within 2s to confirm", button->name());
+    if(auto event = co_await button->next(EventType::BUTTON_LONG_PRESS, 2000)) {
+      ESP_LOGI(LOG_TAG, "Confirmed at %llu", event->timestamp);
+    }
+    else {
+      ESP_LOGI(LOG_TAG, "Confirmation timed out");
+    }
+  }
+}
+#endif
+
 extern "C" void app_main(void) {
   // Create a button using the Kconfig default options.
   Button* button_a = Button::create("Button A", GPIO_NUM_0);
@@ -55,15 +71,11 @@ extern "C" void app_main(void) {
   // Example value to pass through to the event handler.
   uint32_t handler_value = 55;
 
-  // An object who's method is called on an event through a lambda.
+  // An object who's method is called on an event.
   Object object;
 
-  // Add handler for all events on button B.
-  button_b->add_handler(press_any, &handler_value, EventType::BUTTON_DOWN);
-  button_b->add_handler(press_any, &handler_value, EventType::BUTTON_UP);
-  button_b->add_handler(press_any, &handler_value, EventType::BUTTON_PRESS);
-  button_b->add_handler(press_any, &handler_value, EventType::BUTTON_LONG_PRESS);
-  button_b->add_handler(press_any, &handler_value, EventType::BUTTON_HELD);
+  // Add handler for all events on button B, with a single registration.
+  Button::subscribe({button_b}, all_events(), press_any, &handler_value);
 
   // Add handler specifically press and long events on button B
   button_b->add_handler(press_handler, &handler_value, EventType::BUTTON_PRESS);
@@ -73,12 +85,15 @@ extern "C" void app_main(void) {
   button_a->add_handler(long_handler, &handler_value, EventType::BUTTON_LONG_PRESS);
   button_a->add_handler(press_handler, &handler_value, EventType::BUTTON_PRESS);
 
-  button_a->add_handler(
-    [](void* handler_args, esp_event_base_t base, int32_t id, void* event_data) {
-      auto o = static_cast<Object*>(handler_args);
-      o->handler();
-    },
-    &object, EventType::BUTTON_PRESS);
+  // Member functions and capturing lambdas are called with a typed event, and stored without allocating.
+  button_a->add_handler(&object, &Object::handler, EventType::BUTTON_PRESS);
+  button_a->add_handler([&handler_value](EventView event) { ESP_LOGI(LOG_TAG, "Lambda handler: %lu", handler_value); },
+                        EventType::BUTTON_LONG_PRESS);
+
+#if ESP_BE_COROUTINES
+  // Start the coroutine. It runs until the first co_await, after which it is resumed by the event manager.
+  confirm_flow(button_a);
+#endif
 
   ESP_LOGI(LOG_TAG, "Waiting for events...");
   while(1) {
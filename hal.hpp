@@ -0,0 +1,238 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <esp_idf_button_events/platform.hpp>
+
+#if !defined(ESP_PLATFORM)
+  #include <mutex>
+#endif
+
+/**
+ * @brief Thin hardware and RTOS abstraction used by the button engine.
+ * @details The ESP-IDF implementation is in hal_esp.cpp. hal_linux.cpp implements the same interface on top of
+ * a deterministic, virtual time simulator, controlled through sim.hpp.
+ */
+namespace Hal {
+  /**
+   * @brief Timeout value used to wait without a timeout.
+   */
+  constexpr uint64_t wait_forever() { return UINT64_MAX; }
+
+#if defined(ESP_PLATFORM)
+  using LoopHandle = esp_event_loop_handle_t;
+  using SignalBuffer = StaticEventGroup_t;
+  using TaskBuffer = StaticTask_t;
+  using StackWord = StackType_t;
+
+  /**
+   * @brief Critical section, safe to use from tasks and ISRs.
+   */
+  class CriticalSection {
+   public:
+    void IRAM_ATTR lock() { portENTER_CRITICAL_SAFE(&_mux); }
+    void IRAM_ATTR unlock() { portEXIT_CRITICAL_SAFE(&_mux); }
+
+   private:
+    portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+  };
+#else
+  struct Loop;
+  using LoopHandle = Loop*;
+  struct SignalBuffer {};
+  struct TaskBuffer {};
+  using StackWord = uint8_t;
+  using CriticalSection = std::mutex;
+#endif
+
+  /**
+   * @brief Task creation parameters.
+   */
+  struct TaskConfig {
+    const char* name;     ///< The task name.
+    size_t stack_size;    ///< The task stack size, in bytes.
+    unsigned priority;    ///< The task priority.
+    int core;             ///< The core to pin the task to, -1 for no affinity.
+    TaskBuffer* buffer;   ///< Static task control block, or nullptr to allocate from the heap.
+    StackWord* stack;     ///< Static task stack of stack_size bytes, or nullptr to allocate from the heap.
+  };
+
+  /**
+   * @brief A task which waits on a signal and handles the bits which woke it.
+   * @details Expressing tasks as a wait followed by a wake handler lets the simulator run them
+   * deterministically, without threads.
+   */
+  struct Service {
+    using wake_function = void (*)(void* arg, uint32_t bits);
+    using timeout_function = uint64_t (*)(void* arg);
+
+    SignalHandle signal;       ///< The signal the service waits on.
+    uint32_t mask;             ///< The signal bits the service waits for. Received bits are cleared.
+    wake_function wake;        ///< Called with the received bits, which are zero on timeout.
+    timeout_function timeout;  ///< Called before each wait to get the wait timeout in us, or nullptr to wait forever.
+    void* arg;                 ///< Argument passed to wake and timeout.
+  };
+
+  /**
+   * @brief Get the time since boot. Safe to call from ISRs, and placed in IRAM.
+   * @return uint64_t Time in microseconds.
+   */
+  uint64_t time_us();
+
+  /**
+   * @brief Configure a pin as an input, with its interrupt disabled.
+   * @param pin The pin to configure.
+   * @param pull_up Enable the internal pull up resistor.
+   * @param pull_down Enable the internal pull down resistor.
+   */
+  void pin_configure(gpio_num_t pin, bool pull_up, bool pull_down);
+
+  /**
+   * @brief Read the logic level of a pin. Safe to call from ISRs, and placed in IRAM.
+   * @param pin The pin to read.
+   * @return true The pin is high.
+   * @return false The pin is low.
+   */
+  bool pin_level(gpio_num_t pin);
+
+  /**
+   * @brief Attach an ISR to a pin and enable its interrupt on any edge.
+   * @param pin The pin to attach to.
+   * @param isr The ISR to call.
+   * @param arg Argument passed to the ISR.
+   */
+  void pin_attach_isr(gpio_num_t pin, void (*isr)(void* arg), void* arg);
+
+  /**
+   * @brief Create a one shot timer. Callbacks are called from the timer task.
+   * @param callback The function called when the timer expires.
+   * @param arg Argument passed to the callback.
+   * @param name The timer name.
+   * @return TimerHandle
+   */
+  TimerHandle timer_create(void (*callback)(void* arg), void* arg, const char* name);
+
+  /**
+   * @brief Start a one shot timer. Starting a running timer has no effect.
+   * @param timer The timer to start.
+   * @param timeout_us The time until the timer expires.
+   */
+  void timer_start_once(TimerHandle timer, uint64_t timeout_us);
+
+  /**
+   * @brief Stop a timer, if it is running.
+   * @param timer The timer to stop.
+   */
+  void timer_stop(TimerHandle timer);
+
+  /**
+   * @brief Create a signal, a set of bits which services wait on.
+   * @param buffer Static storage for the signal, or nullptr to allocate from the heap.
+   * @return SignalHandle
+   */
+  SignalHandle signal_create(SignalBuffer* buffer);
+
+  /**
+   * @brief Set signal bits from a task.
+   * @param signal The signal to set.
+   * @param bits The bits to set.
+   */
+  void signal_set(SignalHandle signal, uint32_t bits);
+
+  /**
+   * @brief Set signal bits from an ISR.
+   * @param signal The signal to set.
+   * @param bits The bits to set.
+   */
+  void signal_set_from_isr(SignalHandle signal, uint32_t bits);
+
+  /**
+   * @brief Create a task running a service.
+   * @param service The service to run. Must remain valid for the lifetime of the task.
+   * @param config Task creation parameters.
+   */
+  void service_start(Service& service, const TaskConfig& config);
+
+  /**
+   * @brief Busy wait. Safe to call from ISRs, for short waits.
+   * @param us The time to wait, in microseconds.
+   */
+  void delay_us(uint64_t us);
+
+  /**
+   * @brief Get the number of cores tasks can be pinned to.
+   * @return int
+   */
+  int core_count();
+
+  /**
+   * @brief Get the stack high watermark of the calling task.
+   * @return size_t The least free stack space the task has had, in bytes, or 0 if unknown.
+   */
+  size_t task_stack_free();
+
+  /**
+   * @brief Create a queue of fixed size items.
+   * @param length The number of items the queue can hold.
+   * @param item_size The size of each item, in bytes.
+   * @return QueueHandle
+   */
+  QueueHandle queue_create(size_t length, size_t item_size);
+
+  /**
+   * @brief Copy an item to the back of a queue.
+   * @param queue The queue to send to.
+   * @param item The item, of the queue item size.
+   * @param timeout_us The time to wait for space in the queue.
+   * @return true The item was queued.
+   * @return false The queue was full.
+   */
+  bool queue_send(QueueHandle queue, const void* item, uint64_t timeout_us);
+
+  /**
+   * @brief Copy an item from the front of a queue and remove it.
+   * @param queue The queue to receive from.
+   * @param item Set to the item, of the queue item size.
+   * @param timeout_us The time to wait for an item. The simulator never waits.
+   * @return true An item was received.
+   * @return false The queue was empty.
+   */
+  bool queue_receive(QueueHandle queue, void* item, uint64_t timeout_us);
+
+  /**
+   * @brief Create an event loop.
+   * @param config The loop task parameters, or nullptr to create a loop without a task, which is run with loop_run().
+   * @param queue_size The number of events which can be queued.
+   * @return LoopHandle
+   */
+  LoopHandle loop_create(const TaskConfig* config, size_t queue_size);
+
+  /**
+   * @brief Register a handler with an event loop.
+   * @param loop The loop to register with.
+   * @param base The event base, or ESP_EVENT_ANY_BASE.
+   * @param id The event id, or ESP_EVENT_ANY_ID.
+   * @param handler The handler to call.
+   * @param arg Argument passed to the handler.
+   */
+  void loop_register(LoopHandle loop, esp_event_base_t base, int32_t id, esp_event_handler_t handler, void* arg);
+
+  /**
+   * @brief Post an event to an event loop. The event data is copied.
+   * @param loop The loop to post to.
+   * @param base The event base.
+   * @param id The event id.
+   * @param data The event data.
+   * @param size The size of the event data.
+   * @param timeout_us The time to wait for space in the loop queue.
+   * @return true The event was posted.
+   * @return false The loop queue was full.
+   */
+  bool loop_post(LoopHandle loop, esp_event_base_t base, int32_t id, const void* data, size_t size, uint64_t timeout_us);
+
+  /**
+   * @brief Dispatch the oldest event queued on a loop created without a task, if any.
+   * @param loop The loop to run.
+   */
+  void loop_run(LoopHandle loop);
+}  // namespace Hal
@@ -0,0 +1,140 @@
+#include <esp_intr_alloc.h>
+#include <esp_rom_sys.h>
+#include <hal/gpio_ll.h>
+
+#include "hal.hpp"
+
+namespace Hal {
+  namespace {
+    TickType_t to_ticks(const uint64_t timeout_us) {
+      if(timeout_us == wait_forever()) {
+        return portMAX_DELAY;
+      }
+      // Round up, waking early would only cause another wait.
+      constexpr uint64_t us_per_tick = portTICK_PERIOD_MS * 1000;
+      return (timeout_us + us_per_tick - 1) / us_per_tick;
+    }
+
+    BaseType_t to_core(const int core) { return core < 0 ? tskNO_AFFINITY : core; }
+  }  // namespace
+
+  uint64_t IRAM_ATTR time_us() { return esp_timer_get_time(); }
+
+  void pin_configure(gpio_num_t pin, bool pull_up, bool pull_down) {
+    gpio_config_t io_conf = {
+      .pin_bit_mask = 1ULL << pin,
+      .mode = GPIO_MODE_INPUT,
+      .pull_up_en = (pull_up ? GPIO_PULLUP_ENABLE : GPIO_PULLUP_DISABLE),
+      .pull_down_en = (pull_down ? GPIO_PULLDOWN_ENABLE : GPIO_PULLDOWN_DISABLE),
+      .intr_type = GPIO_INTR_DISABLE,
+    };
+    gpio_config(&io_conf);
+  }
+
+  // gpio_get_level() is in flash, the low level read is inlined so the button ISR can run from IRAM.
+  bool IRAM_ATTR pin_level(gpio_num_t pin) { return gpio_ll_get_level(GPIO_LL_GET_HW(GPIO_PORT_0), pin); }
+
+  void pin_attach_isr(gpio_num_t pin, void (*isr)(void* arg), void* arg) {
+    static bool __attribute__((unused)) once = []() {
+#ifdef CONFIG_ESP_BE_ISR_IN_IRAM
+      gpio_install_isr_service(ESP_INTR_FLAG_IRAM);
+#else
+      gpio_install_isr_service(0);
+#endif
+      return true;
+    }();
+
+    gpio_isr_handler_add(pin, isr, arg);
+    gpio_set_intr_type(pin, GPIO_INTR_ANYEDGE);
+    gpio_intr_enable(pin);
+  }
+
+  TimerHandle timer_create(void (*callback)(void* arg), void* arg, const char* name) {
+    esp_timer_create_args_t timer_param = {
+      .callback = callback, .arg = arg, .dispatch_method = ESP_TIMER_TASK, .name = name, .skip_unhandled_events = false};
+    TimerHandle timer = nullptr;
+    esp_timer_create(&timer_param, &timer);
+    return timer;
+  }
+
+  void timer_start_once(TimerHandle timer, uint64_t timeout_us) { esp_timer_start_once(timer, timeout_us); }
+
+  void timer_stop(TimerHandle timer) { esp_timer_stop(timer); }
+
+  SignalHandle signal_create(SignalBuffer* buffer) {
+#ifdef CONFIG_ESP_BE_STATIC_ALLOCATION
+    if(buffer) {
+      return xEventGroupCreateStatic(buffer);
+    }
+#endif
+    return xEventGroupCreate();
+  }
+
+  void signal_set(SignalHandle signal, uint32_t bits) { xEventGroupSetBits(signal, bits); }
+
+  void IRAM_ATTR signal_set_from_isr(SignalHandle signal, uint32_t bits) {
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    xEventGroupSetBitsFromISR(signal, bits, &xHigherPriorityTaskWoken);
+    if(xHigherPriorityTaskWoken) {
+      portYIELD_FROM_ISR();
+    }
+  }
+
+  void IRAM_ATTR delay_us(uint64_t us) { esp_rom_delay_us(us); }
+
+  int core_count() { return portNUM_PROCESSORS; }
+
+  size_t task_stack_free() { return uxTaskGetStackHighWaterMark(nullptr) * sizeof(StackType_t); }
+
+  void service_start(Service& service, const TaskConfig& config) {
+    auto task = [](void* arg) {
+      auto s = static_cast<Service*>(arg);
+      while(true) {
+        auto timeout = s->timeout ? s->timeout(s->arg) : wait_forever();
+        EventBits_t bits = xEventGroupWaitBits(s->signal, s->mask, pdTRUE, pdFALSE, to_ticks(timeout));
+        s->wake(s->arg, bits & s->mask);
+      }
+    };
+
+#ifdef CONFIG_ESP_BE_STATIC_ALLOCATION
+    if(config.buffer && config.stack) {
+      xTaskCreateStaticPinnedToCore(task, config.name, config.stack_size, &service, config.priority, config.stack, config.buffer,
+                                    to_core(config.core));
+      return;
+    }
+#endif
+    xTaskCreatePinnedToCore(task, config.name, config.stack_size, &service, config.priority, NULL, to_core(config.core));
+  }
+
+  QueueHandle queue_create(size_t length, size_t item_size) { return xQueueCreate(length, item_size); }
+
+  bool queue_send(QueueHandle queue, const void* item, uint64_t timeout_us) {
+    return xQueueSend(queue, item, to_ticks(timeout_us)) == pdTRUE;
+  }
+
+  bool queue_receive(QueueHandle queue, void* item, uint64_t timeout_us) {
+    return xQueueReceive(queue, item, to_ticks(timeout_us)) == pdTRUE;
+  }
+
+  LoopHandle loop_create(const TaskConfig* config, size_t queue_size) {
+    esp_event_loop_args_t args = {.queue_size = static_cast<int32_t>(queue_size),
+                                  .task_name = config ? config->name : nullptr,
+                                  .task_priority = config ? config->priority : 0,
+                                  .task_stack_size = config ? config->stack_size : 0,
+                                  .task_core_id = config ? to_core(config->core) : 0};
+    LoopHandle loop = nullptr;
+    // esp_event has no static creation API, the loop is always allocated from the heap.
+    ESP_ERROR_CHECK(esp_event_loop_create(&args, &loop));
+    return loop;
+  }
+
+  void loop_register(LoopHandle loop, esp_event_base_t base, int32_t id, esp_event_handler_t handler, void* arg) {
+    esp_event_handler_instance_register_with(loop, base, id, handler, arg, nullptr);
+  }
+
+  bool loop_post(LoopHandle loop, esp_event_base_t base, int32_t id, const void* data, size_t size, uint64_t timeout_us) {
+    return esp_event_post_to(loop, base, id, const_cast<void*>(data), size, to_ticks(timeout_us)) == ESP_OK;
+  }
+
+  void loop_run(LoopHandle loop) { esp_event_loop_run(loop, 0); }
+}  // namespace Hal
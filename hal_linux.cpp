@@ -0,0 +1,412 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "hal.hpp"
+#include "sim.hpp"
+
+namespace Hal {
+  struct Timer {
+    void (*callback)(void* arg);
+    void* arg;
+    bool active;
+    uint64_t deadline;
+    uint64_t sequence;
+  };
+
+  struct Signal {
+    uint32_t bits;
+  };
+
+  struct Queue {
+    size_t length;
+    size_t item_size;
+    std::deque<std::vector<uint8_t>> items;
+  };
+
+  struct Loop {
+    struct Handler {
+      esp_event_base_t base;
+      int32_t id;
+      esp_event_handler_t handler;
+      void* arg;
+    };
+
+    struct Post {
+      esp_event_base_t base;
+      int32_t id;
+      std::vector<uint8_t> data;
+    };
+
+    bool has_task;
+    bool busy;  ///< The loop task is dispatching, and can't be run again until it returns.
+    unsigned priority;
+    size_t queue_size;
+    std::vector<Handler> handlers;
+    std::deque<Post> queue;
+  };
+}  // namespace Hal
+
+namespace {
+  using namespace Hal;
+
+  struct Pin {
+    bool level;
+    bool driven;
+    bool pending;  ///< An edge occurred while the ISR was running, so the ISR runs again once it returns.
+    void (*isr)(void* arg);
+    void* arg;
+  };
+
+  struct ScheduledLevel {
+    uint64_t time;
+    gpio_num_t pin;
+    bool level;
+  };
+
+  struct ServiceState {
+    Service* service;
+    unsigned priority;
+    uint64_t deadline;
+    bool busy;  ///< The service is in its wake handler, and can't be run again until it returns.
+  };
+
+  struct State {
+    uint64_t now = 0;
+    uint64_t timer_sequence = 0;
+    std::map<int, Pin> pins;
+    std::vector<ScheduledLevel> scheduled;  ///< Sorted by time.
+    bool in_isr = false;
+    std::vector<std::unique_ptr<Timer>> timers;
+    std::vector<std::unique_ptr<Signal>> signals;
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<ServiceState> services;
+    std::vector<std::unique_ptr<Loop>> loops;
+    Sim::Stats stats = {};
+    bool in_service = false;
+    uint64_t nested_ns = 0;
+  };
+
+  State& state() {
+    static State s;
+    return s;
+  }
+
+  uint64_t cpu_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  uint64_t deadline_after(const uint64_t timeout) {
+    return timeout == wait_forever() ? wait_forever() : state().now + timeout;
+  }
+
+  void dispatch(Loop& loop) {
+    auto start = cpu_ns();
+    // Copy out first, handlers may post to the same loop.
+    auto post = std::move(loop.queue.front());
+    loop.queue.pop_front();
+
+    // Same order as esp_event: loop level handlers, then base level handlers, then id specific handlers.
+    auto handlers = loop.handlers;
+    loop.busy = true;
+    auto call = [&](auto match) {
+      for(auto& h: handlers) {
+        if(match(h)) {
+          h.handler(h.arg, post.base, post.id, post.data.data());
+        }
+      }
+    };
+    call([&](const Loop::Handler& h) { return h.base == ESP_EVENT_ANY_BASE; });
+    call([&](const Loop::Handler& h) { return h.base != ESP_EVENT_ANY_BASE && h.base == post.base && h.id == ESP_EVENT_ANY_ID; });
+    call([&](const Loop::Handler& h) { return h.base != ESP_EVENT_ANY_BASE && h.base == post.base && h.id == post.id; });
+    loop.busy = false;
+    auto elapsed = cpu_ns() - start;
+    state().stats.loop_dispatches++;
+    state().stats.loop_cpu_ns += elapsed;
+    // Dispatches from blocked posts run within a service wake, and are only accounted to the loop.
+    state().nested_ns += state().in_service ? elapsed : 0;
+  }
+
+  bool service_runnable(const ServiceState& s) {
+    return !s.busy && ((s.service->signal->bits & s.service->mask) || s.deadline <= state().now);
+  }
+
+  // Run the highest priority runnable service or loop task. Services win ties, as they are the producers.
+  bool run_one() {
+    ServiceState* service = nullptr;
+    Loop* loop = nullptr;
+    for(auto& s: state().services) {
+      if(service_runnable(s) && (!service || s.priority > service->priority)) {
+        service = &s;
+      }
+    }
+    for(auto& l: state().loops) {
+      if(l->has_task && !l->busy && !l->queue.empty() && (!loop || l->priority > loop->priority)) {
+        loop = l.get();
+      }
+    }
+
+    if(service && (!loop || service->priority >= loop->priority)) {
+      auto s = service->service;
+      auto bits = s->signal->bits & s->mask;
+      s->signal->bits &= ~s->mask;
+      auto start = cpu_ns();
+      state().in_service = true;
+      state().nested_ns = 0;
+      service->busy = true;
+      s->wake(s->arg, bits);
+      service->busy = false;
+      state().in_service = false;
+      state().stats.service_wakes++;
+      state().stats.service_cpu_ns += cpu_ns() - start - state().nested_ns;
+      service->deadline = deadline_after(s->timeout ? s->timeout(s->arg) : wait_forever());
+      return true;
+    }
+    if(loop) {
+      dispatch(*loop);
+      return true;
+    }
+    return false;
+  }
+
+  // Change a pin level and run its ISR. Edges during an ISR are latched, as by the GPIO interrupt status.
+  void drive(gpio_num_t pin, bool level) {
+    auto& p = state().pins[pin];
+    p.driven = true;
+    if(p.level == level) {
+      return;
+    }
+    p.level = level;
+    if(!p.isr) {
+      return;
+    }
+    if(state().in_isr) {
+      p.pending = true;
+      return;
+    }
+    state().in_isr = true;
+    p.isr(p.arg);
+    while(p.pending) {
+      p.pending = false;
+      p.isr(p.arg);
+    }
+    state().in_isr = false;
+  }
+
+  // Apply scheduled levels due at or before a time, in order.
+  void drive_scheduled(uint64_t time) {
+    auto& scheduled = state().scheduled;
+    while(!scheduled.empty() && scheduled.front().time <= time) {
+      auto next = scheduled.front();
+      scheduled.erase(scheduled.begin());
+      state().now = next.time > state().now ? next.time : state().now;
+      drive(next.pin, next.level);
+    }
+  }
+
+  Timer* next_timer() {
+    Timer* next = nullptr;
+    for(auto& t: state().timers) {
+      if(t->active && (!next || t->deadline < next->deadline || (t->deadline == next->deadline && t->sequence < next->sequence))) {
+        next = t.get();
+      }
+    }
+    return next;
+  }
+}  // namespace
+
+namespace Hal {
+  uint64_t time_us() { return state().now; }
+
+  void pin_configure(gpio_num_t pin, bool pull_up, bool pull_down) {
+    auto& p = state().pins[pin];
+    if(!p.driven) {
+      p.level = pull_up && !pull_down;
+    }
+  }
+
+  bool pin_level(gpio_num_t pin) { return state().pins[pin].level; }
+
+  void pin_attach_isr(gpio_num_t pin, void (*isr)(void* arg), void* arg) {
+    auto& p = state().pins[pin];
+    p.isr = isr;
+    p.arg = arg;
+  }
+
+  TimerHandle timer_create(void (*callback)(void* arg), void* arg, const char* name) {
+    state().timers.push_back(std::make_unique<Timer>(Timer{callback, arg, false, 0, 0}));
+    return state().timers.back().get();
+  }
+
+  void timer_start_once(TimerHandle timer, uint64_t timeout_us) {
+    if(timer->active) {
+      return;
+    }
+    timer->active = true;
+    timer->deadline = state().now + timeout_us;
+    timer->sequence = state().timer_sequence++;
+  }
+
+  void timer_stop(TimerHandle timer) { timer->active = false; }
+
+  SignalHandle signal_create(SignalBuffer* buffer) {
+    state().signals.push_back(std::make_unique<Signal>(Signal{0}));
+    return state().signals.back().get();
+  }
+
+  void signal_set(SignalHandle signal, uint32_t bits) { signal->bits |= bits; }
+
+  void signal_set_from_isr(SignalHandle signal, uint32_t bits) { signal->bits |= bits; }
+
+  int core_count() { return 1; }
+
+  void delay_us(uint64_t us) {
+    // Busy waiting lets scheduled pin levels change, but nothing else runs.
+    auto end = state().now + us;
+    drive_scheduled(end);
+    state().now = end;
+  }
+
+  // Simulated tasks run on the caller's stack.
+  size_t task_stack_free() { return 0; }
+
+  void service_start(Service& service, const TaskConfig& config) {
+    state().services.push_back(
+      {&service, config.priority, deadline_after(service.timeout ? service.timeout(service.arg) : wait_forever()), false});
+  }
+
+  QueueHandle queue_create(size_t length, size_t item_size) {
+    state().queues.push_back(std::make_unique<Queue>(Queue{length, item_size, {}}));
+    return state().queues.back().get();
+  }
+
+  // Nothing else runs while a simulated task waits, so queue operations never wait.
+  bool queue_send(QueueHandle queue, const void* item, uint64_t timeout_us) {
+    if(queue->items.size() >= queue->length) {
+      return false;
+    }
+    auto bytes = static_cast<const uint8_t*>(item);
+    queue->items.emplace_back(bytes, bytes + queue->item_size);
+    return true;
+  }
+
+  bool queue_receive(QueueHandle queue, void* item, uint64_t timeout_us) {
+    if(queue->items.empty()) {
+      return false;
+    }
+    std::memcpy(item, queue->items.front().data(), queue->item_size);
+    queue->items.pop_front();
+    return true;
+  }
+
+  LoopHandle loop_create(const TaskConfig* config, size_t queue_size) {
+    auto loop = std::make_unique<Loop>();
+    loop->has_task = config != nullptr;
+    loop->busy = false;
+    loop->priority = config ? config->priority : 0;
+    loop->queue_size = queue_size;
+    state().loops.push_back(std::move(loop));
+    return state().loops.back().get();
+  }
+
+  void loop_register(LoopHandle loop, esp_event_base_t base, int32_t id, esp_event_handler_t handler, void* arg) {
+    loop->handlers.push_back({base, id, handler, arg});
+  }
+
+  bool loop_post(LoopHandle loop, esp_event_base_t base, int32_t id, const void* data, size_t size, uint64_t timeout_us) {
+    if(loop->queue.size() >= loop->queue_size) {
+      if(!loop->has_task || timeout_us == 0) {
+        return false;
+      }
+      // A blocked post lets the loop task run until there is space. A busy loop task is modelled as making space
+      // once it returns, so the queue briefly overfills.
+      state().stats.loop_blocked_posts++;
+      if(!loop->busy) {
+        dispatch(*loop);
+      }
+    }
+    auto bytes = static_cast<const uint8_t*>(data);
+    loop->queue.push_back({base, id, std::vector<uint8_t>(bytes, bytes + size)});
+    state().stats.loop_posts++;
+    state().stats.loop_peak_depth = std::max(state().stats.loop_peak_depth, loop->queue.size());
+    return true;
+  }
+
+  void loop_run(LoopHandle loop) {
+    if(!loop->queue.empty()) {
+      dispatch(*loop);
+    }
+  }
+}  // namespace Hal
+
+namespace Sim {
+  uint64_t now() { return state().now; }
+
+  void set_level(gpio_num_t pin, bool level) {
+    drive(pin, level);
+    run();
+  }
+
+  void set_level_at(gpio_num_t pin, bool level, uint64_t time) {
+    auto& scheduled = state().scheduled;
+    auto position = std::upper_bound(scheduled.begin(), scheduled.end(), time,
+                                     [](uint64_t t, const ScheduledLevel& s) { return t < s.time; });
+    scheduled.insert(position, {time, pin, level});
+  }
+
+  bool level(gpio_num_t pin) { return state().pins[pin].level; }
+
+  void run() {
+    while(run_one()) {
+    }
+  }
+
+  uint64_t next_deadline() {
+    auto deadline = UINT64_MAX;
+    if(auto timer = next_timer()) {
+      deadline = timer->deadline;
+    }
+    if(!state().scheduled.empty()) {
+      deadline = std::min(deadline, state().scheduled.front().time);
+    }
+    for(auto& s: state().services) {
+      deadline = !s.busy && s.deadline < deadline ? s.deadline : deadline;
+    }
+    return deadline;
+  }
+
+  void advance_to(uint64_t time) {
+    run();
+    while(true) {
+      auto deadline = next_deadline();
+      if(deadline > time) {
+        break;
+      }
+      state().now = deadline > state().now ? deadline : state().now;
+      drive_scheduled(state().now);
+      run();
+      // The timer task has the highest priority, so all due timers fire before anything else runs.
+      while(auto timer = next_timer()) {
+        if(timer->deadline > state().now) {
+          break;
+        }
+        timer->active = false;
+        timer->callback(timer->arg);
+      }
+      run();
+    }
+    state().now = time > state().now ? time : state().now;
+  }
+
+  void advance(uint64_t us) { advance_to(state().now + us); }
+
+  void spend(uint64_t us) { state().now += us; }
+
+  Stats stats() { return state().stats; }
+
+  void reset_stats() { state().stats = {}; }
+}  // namespace Sim
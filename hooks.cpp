@@ -0,0 +1,25 @@
+#include "hooks_internal.hpp"
+
+#ifdef CONFIG_ESP_BE_HOOKS
+
+  #include "hal.hpp"
+
+namespace ButtonEvents::Hooks {
+  namespace {
+    Sink sink = nullptr;
+    void* sink_arg = nullptr;
+  }  // namespace
+
+  void set_sink(Sink s, void* arg) {
+    sink_arg = arg;
+    sink = s;
+  }
+
+  void IRAM_ATTR emit(const Point point, const size_t button, const uint8_t value) {
+    if(sink) {
+      sink({Hal::time_us(), point, static_cast<uint8_t>(button), value}, sink_arg);
+    }
+  }
+}  // namespace ButtonEvents::Hooks
+
+#endif
@@ -0,0 +1,90 @@
+#include "hooks_file_sink.hpp"
+
+#include <array>
+#include <utility>
+#include <esp_idf_button_events/button.hpp>
+
+namespace ButtonEvents::Hooks {
+  namespace {
+    enum Track { ISR_TRACK = 1, TIMER_TRACK, MANAGER_TRACK, LOOP_TRACK };
+
+    constexpr std::array<const char*, 5> event_names{"BUTTON_UP", "BUTTON_DOWN", "BUTTON_PRESS", "BUTTON_LONG_PRESS", "BUTTON_HELD"};
+
+    const char* event_name(const uint8_t event) { return event < event_names.size() ? event_names[event] : "?"; }
+
+    const char* trigger_name(const uint8_t trigger) {
+      switch(trigger) {
+        case 1: return "edge";
+        case 2: return "debounce";
+        case 4: return "repeat";
+        default: return "?";
+      }
+    }
+  }  // namespace
+
+  FileSink::FileSink(const char* path) : _file(std::fopen(path, "w")), _first(true) {
+    if(!_file) {
+      return;
+    }
+    std::fputs("[", _file);
+    for(auto [track, name]: {std::pair{ISR_TRACK, "gpio isr"}, std::pair{TIMER_TRACK, "esp_timer"},
+                             std::pair{MANAGER_TRACK, "button_event_manager"}, std::pair{LOOP_TRACK, "loop_task"}}) {
+      std::fprintf(_file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                   _first ? "" : ",", track, name);
+      _first = false;
+    }
+  }
+
+  FileSink::~FileSink() {
+    if(_file) {
+      std::fputs("\n]\n", _file);
+      std::fclose(_file);
+    }
+  }
+
+  void FileSink::_write(const char* name, char phase, int track, uint64_t time) {
+    std::fprintf(_file, ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"pid\":0,\"tid\":%d,\"ts\":%llu%s}", name, phase, track,
+                 static_cast<unsigned long long>(time), phase == 'i' ? ",\"s\":\"t\"" : "");
+  }
+
+  void FileSink::write(const Record& record, void* arg) {
+    auto self = static_cast<FileSink*>(arg);
+    if(!self->_file) {
+      return;
+    }
+    char name[64];
+    switch(record.point) {
+      case Point::ISR:
+        std::snprintf(name, sizeof(name), "edge b%u", record.button);
+        self->_write(name, 'i', ISR_TRACK, record.time);
+        break;
+      case Point::DEBOUNCE_TIMER:
+        std::snprintf(name, sizeof(name), "debounced b%u %s", record.button,
+                      record.value == static_cast<uint8_t>(State::PRESSED) ? "pressed" : "released");
+        self->_write(name, 'i', TIMER_TRACK, record.time);
+        break;
+      case Point::HELD_TIMER:
+        std::snprintf(name, sizeof(name), "held b%u", record.button);
+        self->_write(name, 'i', TIMER_TRACK, record.time);
+        break;
+      case Point::WAKE_BEGIN:
+        self->_write("wake", 'B', MANAGER_TRACK, record.time);
+        break;
+      case Point::DECODE:
+        std::snprintf(name, sizeof(name), "decode b%u %s", record.button, trigger_name(record.value));
+        self->_write(name, 'i', MANAGER_TRACK, record.time);
+        break;
+      case Point::WAKE_END:
+        self->_write("wake", 'E', MANAGER_TRACK, record.time);
+        break;
+      case Point::POST:
+        std::snprintf(name, sizeof(name), "post b%u %s", record.button, event_name(record.value));
+        self->_write(name, 'i', MANAGER_TRACK, record.time);
+        break;
+      case Point::DISPATCH:
+        std::snprintf(name, sizeof(name), "dispatch b%u %s", record.button, event_name(record.value));
+        self->_write(name, 'i', LOOP_TRACK, record.time);
+        break;
+    }
+  }
+}  // namespace ButtonEvents::Hooks
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdio>
+#include <esp_idf_button_events/hooks.hpp>
+
+namespace ButtonEvents::Hooks {
+  /**
+   * @brief Host sink writing hook records as a Chrome trace event JSON file, viewable as a timeline in Perfetto or
+   *        chrome://tracing. Each execution context (ISR, timer task, event manager task, event loop task) is a track.
+   * @code
+   * Hooks::FileSink sink("timeline.json");
+   * Hooks::set_sink(Hooks::FileSink::write, &sink);
+   * @endcode
+   */
+  class FileSink {
+   public:
+    /**
+     * @brief Open a timeline file, replacing any existing file.
+     * @param path The file path.
+     */
+    explicit FileSink(const char* path);
+    /**
+     * @brief Complete and close the file.
+     */
+    ~FileSink();
+    FileSink(const FileSink&) = delete;
+    FileSink& operator=(const FileSink&) = delete;
+
+    /**
+     * @brief Check if the file was opened.
+     * @return true The file is open.
+     * @return false The file couldn't be opened, records are discarded.
+     */
+    bool is_open() const { return _file != nullptr; }
+
+    /**
+     * @brief Sink function, for set_sink().
+     * @param record The record to write.
+     * @param arg The FileSink.
+     */
+    static void write(const Record& record, void* arg);
+
+   private:
+    void _write(const char* name, char phase, int track, uint64_t time);
+
+    std::FILE* _file;
+    bool _first;
+  };
+}  // namespace ButtonEvents::Hooks
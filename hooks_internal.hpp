@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <esp_idf_button_events/hooks.hpp>
+
+/**
+ * @brief Internal hook emission. With hooks disabled, emit() is empty and calls to it compile out.
+ */
+namespace ButtonEvents::Hooks {
+#ifdef CONFIG_ESP_BE_HOOKS
+  /**
+   * @brief Emit a record to the sink, if one is set. Safe to call from an ISR.
+   * @param point The hook point.
+   * @param button The button index, or no_button.
+   * @param value Point specific value.
+   */
+  void emit(const Point point, const size_t button, const uint8_t value = 0);
+#else
+  inline void emit(const Point point, const size_t button, const uint8_t value = 0) {}
+#endif
+}  // namespace ButtonEvents::Hooks
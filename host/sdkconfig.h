@@ -0,0 +1,35 @@
+#pragma once
+
+// Kconfig defaults used by the host build. On target, sdkconfig.h is generated by the ESP-IDF build system.
+
+#define CONFIG_ESP_BE_MAX_BUTTON_COUNT         6
+#define CONFIG_ESP_BE_DEFAULT_DEBOUNCE_MS      50
+#define CONFIG_ESP_BE_DEFAULT_SHORT_PRESS_MS   100
+#define CONFIG_ESP_BE_DEFAULT_LONG_PRESS_MS    3000
+#define CONFIG_ESP_BE_DEFAULT_HELD_MS          3000
+#define CONFIG_ESP_BE_DEFAULT_HELD_REPEAT_MS   500
+#define CONFIG_ESP_BE_TASK_STACK_SIZE          2048
+#define CONFIG_ESP_BE_TASK_PRIORITY            8
+#define CONFIG_ESP_BE_EVENT_LOOP_STACK_SIZE    2048
+#define CONFIG_ESP_BE_EVENT_LOOP_TASK_PRIORITY 10
+#define CONFIG_ESP_BE_EVENT_LOOP_QUEUE_SIZE    5
+#define CONFIG_ESP_BE_EVENT_LOOP_TASK_AFFINITY -1
+#define CONFIG_ESP_BE_EVENT_LOOP_COUNT         2
+#define CONFIG_ESP_BE_MAX_INLINE_SUBSCRIBERS   4
+#define CONFIG_ESP_BE_MAX_TYPED_HANDLERS       16
+#define CONFIG_ESP_BE_HANDLER_CAPTURE_WORDS    4
+#define CONFIG_ESP_BE_MAX_SUBSCRIPTIONS        4
+#define CONFIG_ESP_BE_MAX_BATCH_SUBSCRIBERS    2
+#define CONFIG_ESP_BE_BATCH_CAPACITY           16
+#define CONFIG_ESP_BE_EVENT_RING               1
+#define CONFIG_ESP_BE_EVENT_RING_SIZE          32
+#define CONFIG_ESP_BE_MAX_HANDLERS             32
+
+// Diagnostics are enabled on the host, so they are covered by tests and traces can be captured in the simulator.
+#define CONFIG_ESP_BE_TRACE                    1
+#define CONFIG_ESP_BE_TRACE_BUFFER_SIZE        1024
+#define CONFIG_ESP_BE_LATENCY_HISTOGRAMS       1
+#define CONFIG_ESP_BE_STATS                    1
+#define CONFIG_ESP_BE_HOOKS                    1
+#define CONFIG_ESP_BE_HANDLER_WATCHDOG         1
+#define CONFIG_ESP_BE_HANDLER_BUDGET_US        10000
@@ -0,0 +1,7 @@
+#pragma once
+
+// Host build of single task mode, which is a compile time option, on top of the default host configuration.
+
+#include "../sdkconfig.h"
+
+#define CONFIG_ESP_BE_SINGLE_TASK 1
@@ -1,18 +1,15 @@
 #pragma once
 
-#include <driver/gpio.h>
-#include <esp_log.h>
-#include <esp_timer.h>
-#include <freertos/FreeRTOS.h>
-#include <freertos/event_groups.h>
-#include <freertos/task.h>
-#include <freertos/timers.h>
-
+#include <array>
+#include <atomic>
 #include <cstring>
+#include <initializer_list>
 #include <utility>
 
-#include "esp_event.h"
-#include "esp_system.h"
+#include "esp_idf_button_events/coroutine.hpp"
+#include "esp_idf_button_events/handler.hpp"
+#include "esp_idf_button_events/latency.hpp"
+#include "esp_idf_button_events/platform.hpp"
 
 namespace ButtonEvents {
 
@@ -27,7 +24,7 @@ namespace ButtonEvents {
   /**
    * @brief Types of button events which can occur and be registered.
    */
-  enum class EventType {
+  enum class EventType : uint8_t {
     BUTTON_UP,          ///< Button transitions from pressed to not pressed state.
     BUTTON_DOWN,        ///< Button transitions from not pressed to pressed state.
     BUTTON_PRESS,       ///< Button 'short' press event.
@@ -35,16 +32,147 @@ namespace ButtonEvents {
     BUTTON_HELD,        ///< Button held event. Initial and repeat events use this index.
   };
 
+  /**
+   * @brief Get the bit representing an event type in an event mask.
+   * @param event The event type.
+   * @return constexpr uint32_t The event bit.
+   */
+  constexpr uint32_t event_mask(const EventType event) { return 1u << static_cast<uint32_t>(event); }
+
+  /**
+   * @brief Get an event mask holding every event type.
+   * @return constexpr uint32_t The event mask.
+   */
+  constexpr uint32_t all_events() { return event_mask(EventType::BUTTON_HELD) * 2 - 1; }
+
+  /**
+   * @brief Number of event types.
+   */
+  constexpr size_t event_type_count = static_cast<size_t>(EventType::BUTTON_HELD) + 1;
+
+  /**
+   * @brief The event base of the events of all buttons, owned by the component.
+   */
+  ESP_EVENT_DECLARE_BASE(BUTTON_EVENT);
+
+  /**
+   * @brief The event base of batches posted to batch handlers. The event id is the index of the batch subscription.
+   */
+  ESP_EVENT_DECLARE_BASE(BUTTON_BATCH_EVENT);
+
+  /**
+   * @brief Get the esp_event id of an event of a button. The button index is held above the three event type bits, so
+   *        the event loop matches handlers to a single button and event without comparing names.
+   * @param index The button index.
+   * @param event The event type.
+   * @return constexpr int32_t The event id.
+   */
+  constexpr int32_t event_id(const size_t index, const EventType event) {
+    return static_cast<int32_t>((index << 3) | static_cast<uint32_t>(event));
+  }
+  static_assert(static_cast<uint32_t>(EventType::BUTTON_HELD) < 8, "Event ids hold 3 bit event types.");
+
+  /**
+   * @brief Where an event handler is called.
+   */
+  enum class Context {
+    LOOP,    ///< On the event loop task, after the event is posted. Handlers can take as long as needed.
+    INLINE,  ///< On the event manager task, as soon as the event is classified. Handlers must be short and not block.
+  };
+
+  /**
+   * @brief Task configuration of an event manager. Defaults are taken from Kconfig.
+   */
+  struct ManagerConfig {
+    const char* name = "button_event_manager";            ///< The event manager task name.
+    unsigned priority = CONFIG_ESP_BE_TASK_PRIORITY;       ///< The event manager task priority.
+    int core = -1;                                         ///< The event manager task core, -1 for no affinity.
+    const char* loop_name = "loop_task";                   ///< The event loop task name.
+#ifdef CONFIG_ESP_BE_SINGLE_TASK
+    unsigned loop_priority = 0;                            ///< Unused, handlers run on the event manager task.
+    int loop_core = -1;                                    ///< Unused, handlers run on the event manager task.
+#else
+    unsigned loop_priority = CONFIG_ESP_BE_EVENT_LOOP_TASK_PRIORITY;  ///< The event loop task priority.
+    int loop_core = CONFIG_ESP_BE_EVENT_LOOP_TASK_AFFINITY;           ///< The event loop task core, -1 for no affinity.
+#endif
+  };
+
   /**
    * @brief Forward declaration of the Event manager.
    */
   class EventManager;
 
+  /**
+   * @brief Create an additional event manager, with its own tasks, event groups and event loops.
+   * @details Buttons are bound to a manager with ButtonBuilder::manager(), and use the default manager otherwise.
+   * Separate managers isolate buttons with different latency requirements, for example a high priority manager for
+   * safety inputs pinned to one core and a low priority manager for the user interface on the other. Managers are
+   * allocated from the heap and never destroyed.
+   * @code
+   * EventManager* safety = ButtonEvents::create_manager({.name = "safety_buttons", .priority = 20, .core = 0});
+   * Button* stop = Button::create("Stop", GPIO_NUM_4).manager(safety);
+   * @endcode
+   * @param config The task configuration.
+   * @return EventManager*
+   */
+  EventManager* create_manager(const ManagerConfig& config);
+
+  /**
+   * @brief Initialise the default event manager task, event groups and event loop.
+   * @details Called implicitly when the first event of a button on the default manager is subscribed. Call this
+   * explicitly during boot for the allocations and task creation to occur at a deterministic point. Safe to call from
+   * several tasks, further calls have no effect.
+   */
+  void init();
+
   /**
    * @brief Forward declaration of the button builder.
    */
   class ButtonBuilder;
 
+  /**
+   * @brief Forward declaration of the event data passed to handlers.
+   */
+  class EventData;
+
+  /**
+   * @brief Forward declaration of the event view passed to typed handlers.
+   */
+  class EventView;
+
+  /**
+   * @brief Identifies a handler added with Button::add_handler(), to remove it with Button::remove_handler().
+   * @details Empty when the handler could not be added.
+   */
+  struct HandlerHandle {
+    EventManager* manager = nullptr;  ///< The event manager holding the handler.
+    uint16_t index = 0;                ///< The handler table entry.
+    uint16_t generation = 0;           ///< Generation of the entry, so handles of removed handlers never match its reuse.
+    bool inline_entry = false;         ///< True for handlers and queues called from the event manager task.
+    /**
+     * @brief Check if the handle refers to an added handler.
+     */
+    explicit operator bool() const { return manager; }
+  };
+
+  /**
+   * @brief A typed handler, stored in the fixed size handler table.
+   */
+  using TypedHandler = InplaceFunction<EventView, CONFIG_ESP_BE_HANDLER_CAPTURE_WORDS * sizeof(void*)>;
+
+  class Button;
+
+  /**
+   * @brief Callback called directly from the button ISR, on an edge to a new state.
+   * @details Intended for emergency stop and interlock inputs. The callback runs in interrupt context, so it must be
+   * placed in IRAM, must not block and may only call ISR safe functions. With CONFIG_ESP_BE_ISR_IN_IRAM it also
+   * runs during flash writes.
+   * @param button The button.
+   * @param state The new state of the button.
+   * @param arg The argument given with the callback.
+   */
+  using CriticalCallback = void (*)(Button* button, State state, void* arg);
+
   class Button {
    public:
     /**
@@ -55,7 +183,7 @@ namespace ButtonEvents {
      * @warning Buttons are constructed on the heap and remain initialised until reset.
      * @todo Buttons need a method for being deitialised. Should be handled in the destructor
      * and possible wrapped with smart pointers.
-     * @param name The name of the button. The names of each button must be unique.
+     * @param name The name of the button, used in logs. Names need not be unique.
      * @param pin The pin on which the button resides.
      * @return ButtonBuilder
      */
@@ -65,23 +193,167 @@ namespace ButtonEvents {
      * @param handler The handler to be called.
      * @param arg An argument passed to the event handler.
      * @param event The event to which the handler should be registered.
+     * @param context Where the handler is called. Up to CONFIG_ESP_BE_MAX_HANDLERS event loop handlers and
+     * CONFIG_ESP_BE_MAX_INLINE_SUBSCRIBERS inline handlers and queues can be added to each event manager.
+     * @return HandlerHandle A handle to remove the handler with, empty if the handler table is full.
+     */
+    HandlerHandle add_handler(esp_event_handler_t handler, void* arg, EventType event, Context context = Context::LOOP);
+    /**
+     * @brief Send the EventRecord of an event to a queue when the event occurs.
+     * @details The event is sent from the event manager task without waiting. If the queue is full, the event is
+     * dropped for this queue.
+     * @param queue A queue with items of sizeof(EventRecord).
+     * @param event The event to which the queue should be registered.
+     * @return HandlerHandle A handle to remove the queue with, empty if the handler table is full.
+     */
+    HandlerHandle add_handler(Hal::QueueHandle queue, EventType event);
+    /**
+     * @brief Add a lambda, function or function object called with an EventView when the specified event occurs.
+     * @details The handler is stored in place in a table of CONFIG_ESP_BE_MAX_TYPED_HANDLERS entries, without
+     * allocating. Captures are limited to CONFIG_ESP_BE_HANDLER_CAPTURE_WORDS pointers, checked at compile time.
+     * @code
+     * button->add_handler([&counter](EventView event) { counter++; }, EventType::BUTTON_PRESS);
+     * @endcode
+     * @param handler The handler to be called.
+     * @param event The event to which the handler should be registered.
+     * @param context Where the handler is called.
+     * @return HandlerHandle A handle to remove the handler with, empty if a handler table is full.
+     */
+    template<typename handler_type, typename = std::enable_if_t<std::is_invocable_v<handler_type&, EventView>>>
+    HandlerHandle add_handler(handler_type&& handler, EventType event, Context context = Context::LOOP);
+    /**
+     * @brief Add a member function called with an EventView when the specified event occurs.
+     * @details The object must outlive the button. Stored in the typed handler table.
+     * @param object The object to call the member function on.
+     * @param method The member function to be called.
+     * @param event The event to which the handler should be registered.
+     * @param context Where the handler is called.
+     * @return HandlerHandle A handle to remove the handler with, empty if a handler table is full.
+     */
+    template<typename object_type>
+    HandlerHandle add_handler(object_type* object, void (object_type::*method)(EventView), EventType event,
+                              Context context = Context::LOOP);
+    /**
+     * @brief Remove a handler or queue added with add_handler().
+     * @details Takes constant time and is safe while events are dispatched, including from within the handler
+     * being removed. The handler is not called for events dispatched after this returns, and its table entry is
+     * reused by the next handler added for the same button and event. The callable of a typed handler is kept until
+     * it has returned from every running dispatch, so once the typed handler table is full, adding a handler from
+     * within the one being removed fails.
+     * @param handle The handle returned by add_handler().
+     * @return true The handler was removed.
+     * @return false The handle is empty, or the handler was already removed.
      */
-    void add_handler(esp_event_handler_t handler, void* arg, EventType event);
+    static bool remove_handler(const HandlerHandle& handle);
+    /**
+     * @brief Add a handler called for a set of events on a set of buttons, with a single registration.
+     * @details The handler is registered once on each event loop serving the buttons, and matched against a button
+     * and event bit mask at dispatch, rather than registered per button and event. Subscriptions are held in a table of
+     * CONFIG_ESP_BE_MAX_SUBSCRIPTIONS entries, and are not timed by the handler watchdog.
+     * @code
+     * Button::subscribe({ok, back}, event_mask(EventType::BUTTON_PRESS) | event_mask(EventType::BUTTON_HELD), handler, nullptr);
+     * @endcode
+     * @param buttons The buttons, which must all be bound to the same event manager.
+     * @param events A mask of the events, built with event_mask() or all_events().
+     * @param handler The handler to be called.
+     * @param arg An argument passed to the event handler.
+     * @return true The subscription was added.
+     * @return false The subscription table is full, no buttons were given or they are bound to different managers.
+     */
+    static bool subscribe(std::initializer_list<Button*> buttons, const uint32_t events, esp_event_handler_t handler, void* arg);
+    /**
+     * @brief Add a handler called for a set of events on all buttons of the default event manager, with a single
+     *        registration. Buttons created afterwards are not included.
+     * @param events A mask of the events, built with event_mask() or all_events().
+     * @param handler The handler to be called.
+     * @param arg An argument passed to the event handler.
+     * @return true The subscription was added.
+     * @return false The subscription table is full, or there are no buttons.
+     */
+    static bool subscribe_all(const uint32_t events, esp_event_handler_t handler, void* arg);
+    /**
+     * @brief Add a handler called with batches of events on a set of buttons, read with EventBatch.
+     * @details The event manager collects the events of one wake, or of a window starting at the first event of the
+     * batch, and posts them to the event loop as one contiguous array. A batch is also posted once it holds
+     * CONFIG_ESP_BE_BATCH_CAPACITY events. Suits high rate consumers such as loggers, which can then write a batch in
+     * one go. Batch subscriptions are held in a table of CONFIG_ESP_BE_MAX_BATCH_SUBSCRIBERS entries per manager, and
+     * are not timed by the handler watchdog.
+     * @param buttons The buttons, which must all be bound to the same event manager.
+     * @param events A mask of the events, built with event_mask() or all_events().
+     * @param handler The handler to be called.
+     * @param arg An argument passed to the event handler.
+     * @param window_us Time from the first event of a batch to posting it. 0 posts the events of each wake.
+     * @return true The subscription was added.
+     * @return false The batch table is full, no buttons were given or they are bound to different managers.
+     */
+    static bool subscribe_batch(std::initializer_list<Button*> buttons, const uint32_t events, esp_event_handler_t handler, void* arg,
+                                const uint32_t window_us = 0);
+#if ESP_BE_COROUTINES
+    /**
+     * @brief Wait, within a coroutine, for the next occurrence of an event.
+     * @details The awaiting coroutine is resumed from the event manager task when the event is dispatched,
+     * so code following the co_await runs on the event manager task until the coroutine suspends again.
+     * @code
+     * auto event = co_await button->next(EventType::BUTTON_PRESS);
+     * @endcode
+     * @param event The event to wait for.
+     * @return Coroutine::Awaitable<EventData> Awaitable resolving to the event data.
+     */
+    Coroutine::Awaitable<EventData> next(EventType event);
+    /**
+     * @brief Wait, within a coroutine, for the next occurrence of an event or a timeout.
+     * @code
+     * if(auto event = co_await button->next(EventType::BUTTON_LONG_PRESS, 2000)) {
+     *   // Long pressed within 2s.
+     * }
+     * @endcode
+     * @param event The event to wait for.
+     * @param timeout_ms The maximum time to wait, in ms.
+     * @return Coroutine::TimedAwaitable<EventData> Awaitable resolving to the event data, or empty on timeout.
+     */
+    Coroutine::TimedAwaitable<EventData> next(EventType event, const size_t timeout_ms);
+#endif
     /**
      * @brief Get the current state of the button.
+     * @details For buttons without any subscribed events, the pin is read directly.
      * @return State
      */
     State current_state() const;
     /**
      * @brief Get the time at which the last button transition occured.
-     * @return size_t
+     * @details Written by the event manager task. Handlers should use the press duration in the event data instead.
+     * @return uint64_t Time in microseconds.
+     */
+    uint64_t last_transition() const;
+    /**
+     * @brief Get the user context set with ButtonBuilder::context().
+     * @return void*
      */
-    size_t last_transition() const;
+    void* context() const;
     /**
      * @brief Get the name of the button.
      * @return const char*
      */
     const char* name() const;
+    /**
+     * @brief Get the index of the button, unique among all buttons.
+     * @return size_t
+     */
+    size_t index() const;
+    /**
+     * @brief Get a button by its index.
+     * @param index The button index.
+     * @return Button* The button, or nullptr if there is no button with the index.
+     */
+    static Button* from_index(const size_t index);
+#ifdef CONFIG_ESP_BE_LATENCY_HISTOGRAMS
+    /**
+     * @brief Get a snapshot of the latency histogram of a pipeline stage.
+     * @param stage The stage.
+     * @return Latency::Histogram
+     */
+    Latency::Histogram latency(const Latency::Stage stage) const;
+#endif
 
    private:
     Button(const char* name, gpio_num_t pin);
@@ -99,25 +371,58 @@ namespace ButtonEvents {
     size_t _hold_repeat;
 
     void _pin_init(const bool pull_up, const bool pull_down);
+#ifdef CONFIG_ESP_BE_EVENT_RING
+    void _join_ring();
+#endif
+    void _allocate(const uint32_t mask);
+    static TypedHandler* _allocate_handler();
+    static void _release_handler(void* handler);
+    /**
+     * @brief Mark a typed handler as running, so _allocate_handler() doesn't reuse it if it's removed meanwhile. The
+     *        dispatch must check its table entry is unchanged after this, and call _exit_handler() when it returns.
+     */
+    static void _enter_handler(void* handler);
+    static void _exit_handler(void* handler);
+    static EventManager* _bind(Button* const* buttons, const size_t count, const uint32_t events, uint32_t& button_mask);
+    static void _typed_handler(void* handler_args, esp_event_base_t base, int32_t id, void* event_data);
 
     // Common ISR and timer expired events.
     static void button_isr_handler(void* arg);
     static void timer_debounce_callback(void* arg);
     static void timer_held_callback(void* arg);
+    void _critical_edge();
 
     // Button interaction with event manager
     friend class EventManager;
+    EventManager* _manager;
+    size_t _index;
     uint32_t _press_event_bit;
     uint32_t _timer_event_bit;
     uint32_t _repeat_event_bit;
-    EventGroupHandle_t _event_group;
+    Hal::SignalHandle _event_group;
 
     // Internal button state.
     State _current_state;
     bool _debounce_active;
     uint64_t _transition_time;
-    esp_timer_handle_t _debounce_timer;
-    esp_timer_handle_t _held_timer;
+    std::array<uint8_t, event_type_count> _sequence;
+    uint8_t _held_count;
+    void* _context;
+    Hal::TimerHandle _debounce_timer;
+    Hal::TimerHandle _held_timer;
+
+    // ISR context callback.
+    CriticalCallback _critical;
+    void* _critical_arg;
+    uint32_t _glitch_filter_us;
+    State _critical_state;
+
+#ifdef CONFIG_ESP_BE_STATS
+    // Runtime statistics, reported by the event manager. Initialised here, so the constructor is the same either way.
+    std::atomic<uint32_t> _edges = 0;
+    std::atomic<uint32_t> _spurious = 0;
+    State _reported_state = State::NOT_PRESSED;
+#endif
   };
 
   /**
@@ -190,6 +495,29 @@ namespace ButtonEvents {
      * @return ButtonBuilder&
      */
     ButtonBuilder& hold_repeat_ms(const size_t ms);
+    /**
+     * @brief Set a callback called from the button ISR on each edge to a new state, bypassing all tasks.
+     * @details Events are still generated as normal. With a glitch filter, the ISR busy waits for the filter time
+     * and rereads the pin, ignoring edges which didn't last. This delays the callback and is spent with interrupts
+     * held off, so the filter should be a few microseconds at most.
+     * @param callback The callback, which must be IRAM safe.
+     * @param arg An argument passed to the callback.
+     * @param glitch_filter_us The time a new level must be stable for, in us, or 0 for no filter.
+     * @return ButtonBuilder&
+     */
+    ButtonBuilder& critical(CriticalCallback callback, void* arg, const uint32_t glitch_filter_us = 0);
+    /**
+     * @brief Bind the button to an event manager created with create_manager(), instead of the default manager.
+     * @param manager The event manager which classifies and dispatches the button's events.
+     * @return ButtonBuilder&
+     */
+    ButtonBuilder& manager(EventManager* manager);
+    /**
+     * @brief Set a user context pointer, passed to handlers in the event data.
+     * @param context The context.
+     * @return ButtonBuilder&
+     */
+    ButtonBuilder& context(void* context);
 
     /**
      * @brief Implicitly converts the builder class to a button.
@@ -197,6 +525,14 @@ namespace ButtonEvents {
      */
     operator Button*() {
       _button->_pin_init(_pull_up, _pull_down);
+      if(_button->_critical) {
+        // The ISR is needed from the start, rather than from the first subscription.
+        _button->_allocate(0);
+      }
+#ifdef CONFIG_ESP_BE_EVENT_RING
+      // Ring readers cover buttons created after them.
+      _button->_join_ring();
+#endif
       return std::move(_button);
     }
 
@@ -206,8 +542,134 @@ namespace ButtonEvents {
     bool _pull_down;
   };
 
+  /**
+   * @brief The event data posted to the event loop and passed to handlers. Read it with EventView or EventData.
+   * @details The button is identified by its index rather than a pointer, so the record packs into 16 bytes next to
+   * the timestamp on all targets.
+   */
+  struct EventRecord {
+    uint64_t timestamp;    ///< Timestamp in microseconds, at which the event occured.
+    uint32_t duration_us;  ///< Time the button was pressed for, saturating. 0 for BUTTON_DOWN.
+    uint8_t button;        ///< Index of the button on which the event occured.
+    EventType event;       ///< The type of event which occured.
+    uint8_t sequence;      ///< Incremented for each event sent of this type for the button, wrapping. See EventView::sequence().
+    uint8_t repeat;        ///< BUTTON_HELD repeat index, 0 for the first, saturating. 0 for other events.
+  };
+  static_assert(sizeof(EventRecord) == 16, "Event records are expected to pack into 16 bytes.");
+  static_assert(CONFIG_ESP_BE_MAX_BUTTON_COUNT <= UINT8_MAX, "Event records hold 8 bit button indices.");
+
+  /**
+   * @brief Reads event data passed to button event handlers in place, without copying it.
+   * @details Only valid within the handler, while the event data is.
+   */
+  class EventView {
+   public:
+    /**
+     * @brief Construct a view of event handler event data.
+     * @param event_data Event data received in event handler.
+     */
+    explicit EventView(const void* event_data) : _record(static_cast<const EventRecord*>(event_data)) {}
+    /**
+     * @brief Get the button on which the event occured.
+     * @return Button*
+     */
+    Button* button() const { return Button::from_index(_record->button); }
+    /**
+     * @brief Get the index of the button on which the event occured.
+     * @return size_t
+     */
+    size_t index() const { return _record->button; }
+    /**
+     * @brief Get the timestamp at which the event occured.
+     * @return uint64_t Timestamp in microseconds.
+     */
+    uint64_t timestamp() const { return _record->timestamp; }
+    /**
+     * @brief Get the type of event which occured.
+     * @return EventType
+     */
+    EventType event() const { return _record->event; }
+    /**
+     * @brief Get the time the button was pressed for. For BUTTON_HELD, the time it has been pressed for so far.
+     * @return uint32_t Duration in microseconds, 0 for BUTTON_DOWN.
+     */
+    uint32_t duration_us() const { return _record->duration_us; }
+    /**
+     * @brief Get the sequence number of the event. Each button counts the events sent of each type separately, so
+     *        consecutive events of a type a consumer receives are numbered consecutively, and a gap is a drop: a full
+     *        handler queue, or records a ring reader lost. The number is 8 bit and wraps at 256, so a gap is only
+     *        known modulo 256.
+     * @return uint8_t
+     */
+    uint8_t sequence() const { return _record->sequence; }
+    /**
+     * @brief Get the BUTTON_HELD repeat index.
+     * @return uint8_t 0 for the first BUTTON_HELD after a press, saturating at 255. 0 for other events.
+     */
+    uint8_t repeat() const { return _record->repeat; }
+    /**
+     * @brief Get the user context of the button, set with ButtonBuilder::context().
+     * @return void*
+     */
+    void* context() const { return button()->context(); }
+
+   private:
+    const EventRecord* _record;
+  };
+
+  /**
+   * @brief Reads a batch of event records passed to batch handlers in place, oldest first.
+   * @details Only valid within the handler, while the event data is.
+   * @code
+   * for(auto& record: EventBatch(event_data)) {
+   *   log_write(&record, sizeof(record));
+   * }
+   * @endcode
+   */
+  class EventBatch {
+   public:
+    /**
+     * @brief Header of the batch event data, followed by the records.
+     */
+    struct Header {
+      uint32_t count;     ///< Number of records in the batch.
+      uint32_t reserved;  ///< Keeps the records 8 byte aligned.
+    };
+
+    /**
+     * @brief Construct a view of batch handler event data.
+     * @param event_data Event data received in the batch handler.
+     */
+    explicit EventBatch(const void* event_data) : _header(static_cast<const Header*>(event_data)) {}
+    /**
+     * @brief Get the number of events in the batch.
+     * @return size_t
+     */
+    size_t size() const { return _header->count; }
+    /**
+     * @brief Get the first record of the batch.
+     * @return const EventRecord*
+     */
+    const EventRecord* begin() const { return reinterpret_cast<const EventRecord*>(_header + 1); }
+    /**
+     * @brief Get the end of the records of the batch.
+     * @return const EventRecord*
+     */
+    const EventRecord* end() const { return begin() + size(); }
+    /**
+     * @brief Get a view of an event in the batch.
+     * @param index The position of the event in the batch, less than size().
+     * @return EventView
+     */
+    EventView operator[](const size_t index) const { return EventView(begin() + index); }
+
+   private:
+    const Header* _header;
+  };
+
   /**
    * @brief Converts event data passed to button event handlers to a useful form.
+   * @details Copies the event data. Use EventView to read it in place.
    */
   class EventData {
    public:
@@ -215,8 +677,18 @@ namespace ButtonEvents {
      * @brief Construct a new Event Data object from event handler raw pointer.
      * @param event_data Event data received in event handler.
      */
-    explicit EventData(void* event_data) { std::memcpy(this, event_data, sizeof(*this)); }
-    EventData() : button(nullptr), timestamp(0), event(EventType::BUTTON_PRESS) {}
+    explicit EventData(const void* event_data) {
+      EventView view(event_data);
+      button = view.button();
+      timestamp = view.timestamp();
+      event = view.event();
+      duration_us = view.duration_us();
+      sequence = view.sequence();
+      repeat = view.repeat();
+      context = button ? button->context() : nullptr;
+    }
+    EventData()
+      : button(nullptr), timestamp(0), event(EventType::BUTTON_PRESS), duration_us(0), sequence(0), repeat(0), context(nullptr) {}
     /**
      * @brief Pointer to the button on which the event occured.
      */
@@ -229,8 +701,43 @@ namespace ButtonEvents {
      * @brief The type of event which occured.
      */
     EventType event;
+    /**
+     * @brief Time the button was pressed for, in microseconds. See EventView::duration_us().
+     */
+    uint32_t duration_us;
+    /**
+     * @brief Sequence number of the event. See EventView::sequence().
+     */
+    uint8_t sequence;
+    /**
+     * @brief BUTTON_HELD repeat index. See EventView::repeat().
+     */
+    uint8_t repeat;
+    /**
+     * @brief The user context of the button.
+     */
+    void* context;
   };
 
+  template<typename handler_type, typename>
+  HandlerHandle Button::add_handler(handler_type&& handler, EventType event, Context context) {
+    auto entry = _allocate_handler();
+    if(!entry) {
+      return {};
+    }
+    entry->emplace(std::forward<handler_type>(handler));
+    auto handle = add_handler(_typed_handler, entry, event, context);
+    if(!handle) {
+      _release_handler(entry);
+    }
+    return handle;
+  }
+
+  template<typename object_type>
+  HandlerHandle Button::add_handler(object_type* object, void (object_type::*method)(EventView), EventType event, Context context) {
+    return add_handler([object, method](EventView view) { (object->*method)(view); }, event, context);
+  }
+
   /**
    * @brief Convert milliseconds to microseconds.
    *
@@ -0,0 +1,230 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <optional>
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+  #include <coroutine>
+  #define ESP_BE_COROUTINES 1
+#else
+  #define ESP_BE_COROUTINES 0
+#endif
+
+#if ESP_BE_COROUTINES
+
+namespace Coroutine {
+  /**
+   * @brief Value used by waiters which have no deadline.
+   */
+  constexpr uint64_t no_deadline() { return UINT64_MAX; }
+
+  /**
+   * @brief Fire and forget coroutine return type.
+   * @details The coroutine starts running immediately and its frame is released when the body returns.
+   * Nothing needs to keep hold of the returned object.
+   */
+  struct Task {
+    struct promise_type {
+      Task get_return_object() { return {}; }
+      std::suspend_never initial_suspend() noexcept { return {}; }
+      std::suspend_never final_suspend() noexcept { return {}; }
+      void return_void() {}
+      void unhandled_exception() { std::terminate(); }
+    };
+  };
+
+  /**
+   * @brief A suspended coroutine waiting for an event.
+   * @details Waiters live inside the awaiting coroutine frame for as long as it is suspended, so the
+   * wait list links them together without allocating.
+   * @tparam value_type The value handed to the coroutine when it resumes.
+   */
+  template<typename value_type>
+  struct Waiter {
+    const void* source;             ///< The source the waiter is interested in.
+    uint32_t mask;                  ///< Bit mask of the event indexes the waiter is interested in.
+    uint64_t timeout;               ///< Timeout requested by the awaiter. Zero waits forever.
+    uint64_t deadline;              ///< Absolute deadline, set when the waiter is added to a list.
+    std::coroutine_handle<> handle;  ///< The coroutine to resume.
+    value_type value;               ///< The value received, valid if received is set.
+    bool received;                  ///< Set true if the waiter was resumed by an event, false on timeout.
+    Waiter* next;                   ///< Intrusive list link.
+  };
+
+  /// @brief An intrusive list of coroutines waiting for events.
+  /// @details Coroutines are always resumed outside of the lock, so a resumed coroutine may
+  /// immediately wait again on the same list.
+  /// @tparam value_type The value handed to resumed coroutines.
+  /// @tparam lock_type A type providing lock() and unlock().
+  template<typename value_type, typename lock_type>
+  class WaitList {
+   public:
+    using waiter = Waiter<value_type>;
+
+    WaitList() : _head(nullptr) {}
+
+    /**
+     * @brief Add a waiter to the list. The waiter deadline must already be set.
+     * @param item The waiter to add.
+     * @return true The waiter has the earliest deadline in the list.
+     * @return false Another waiter expires before, or at the same time as this one.
+     */
+    bool push(waiter* item) {
+      _lock.lock();
+      auto earliest = item->deadline < _next_deadline();
+      item->next = _head;
+      _head = item;
+      _lock.unlock();
+      return earliest;
+    }
+
+    /**
+     * @brief Resume all waiters for a source which are interested in an event.
+     * @param source The source on which the event occured.
+     * @param event_index The index of the event which occured.
+     * @param value The value handed to each resumed waiter.
+     * @return size_t The number of resumed waiters.
+     */
+    size_t notify(const void* source, const size_t event_index, const value_type& value) {
+      const uint32_t bit = 1u << event_index;
+      return _resume(_take([&](const waiter* item) { return item->source == source && (item->mask & bit); }),
+                     [&](waiter* item) {
+                       item->value = value;
+                       item->received = true;
+                     });
+    }
+
+    /**
+     * @brief Resume all waiters whose deadline has passed.
+     * @param now The current time, in the same units as the deadlines.
+     * @return size_t The number of resumed waiters.
+     */
+    size_t expire(const uint64_t now) {
+      return _resume(_take([&](const waiter* item) { return item->deadline <= now; }), [](waiter* item) { item->received = false; });
+    }
+
+    /**
+     * @brief Get the earliest deadline in the list.
+     * @return uint64_t The deadline, or no_deadline() if nothing in the list expires.
+     */
+    uint64_t next_deadline() {
+      _lock.lock();
+      auto deadline = _next_deadline();
+      _lock.unlock();
+      return deadline;
+    }
+
+    /**
+     * @brief Query if any coroutines are waiting.
+     * @return true No coroutines are waiting.
+     * @return false At least one coroutine is waiting.
+     */
+    bool empty() {
+      _lock.lock();
+      auto result = _head == nullptr;
+      _lock.unlock();
+      return result;
+    }
+
+   private:
+    uint64_t _next_deadline() const {
+      auto deadline = no_deadline();
+      for(auto item = _head; item != nullptr; item = item->next) {
+        deadline = item->deadline < deadline ? item->deadline : deadline;
+      }
+      return deadline;
+    }
+
+    template<typename predicate_type>
+    waiter* _take(predicate_type predicate) {
+      waiter* taken = nullptr;
+      _lock.lock();
+      auto link = &_head;
+      while(*link != nullptr) {
+        auto item = *link;
+        if(predicate(item)) {
+          *link = item->next;
+          item->next = taken;
+          taken = item;
+        }
+        else {
+          link = &item->next;
+        }
+      }
+      _lock.unlock();
+      return taken;
+    }
+
+    template<typename update_type>
+    static size_t _resume(waiter* taken, update_type update) {
+      size_t count = 0;
+      while(taken != nullptr) {
+        // The waiter lives in the coroutine frame, which may be released once resumed.
+        auto item = taken;
+        taken = taken->next;
+        update(item);
+        item->handle.resume();
+        count++;
+      }
+      return count;
+    }
+
+    waiter* _head;
+    lock_type _lock;
+  };
+
+  /// @brief Awaitable returned when waiting for an event without a timeout.
+  /// @tparam value_type The value returned by co_await.
+  template<typename value_type>
+  class Awaitable {
+   public:
+    using waiter = Waiter<value_type>;
+    using add_function = void (*)(void* context, waiter& item);
+
+    /**
+     * @brief Construct a new Awaitable.
+     * @param add Function used to add the waiter to a wait list once the coroutine suspends.
+     * @param context Context passed to the add function.
+     * @param source The source to wait on.
+     * @param mask Bit mask of event indexes to wait for.
+     * @param timeout Timeout passed through to the add function. Zero waits forever.
+     */
+    Awaitable(add_function add, void* context, const void* source, const uint32_t mask, const uint64_t timeout = 0) :
+      _add(add), _context(context), _waiter{source, mask, timeout, no_deadline(), nullptr, value_type(), false, nullptr} {}
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> handle) {
+      // The coroutine may be resumed from another task before this returns, so nothing may be touched after adding.
+      _waiter.handle = handle;
+      _add(_context, _waiter);
+    }
+
+    value_type await_resume() { return _waiter.value; }
+
+   protected:
+    add_function _add;
+    void* _context;
+    waiter _waiter;
+  };
+
+  /// @brief Awaitable returned when waiting for an event with a timeout.
+  /// @details co_await returns an empty optional if the timeout expired first.
+  /// @tparam value_type The value returned by co_await, when an event is received.
+  template<typename value_type>
+  class TimedAwaitable : public Awaitable<value_type> {
+   public:
+    using Awaitable<value_type>::Awaitable;
+
+    std::optional<value_type> await_resume() {
+      if(this->_waiter.received) {
+        return this->_waiter.value;
+      }
+      return std::nullopt;
+    }
+  };
+}  // namespace Coroutine
+
+#endif
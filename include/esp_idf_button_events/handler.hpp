@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace ButtonEvents {
+  /**
+   * @brief A type erased callable, stored in place without allocating.
+   * @details Holds a lambda, function pointer or function object of up to storage_size bytes. The callable is
+   * constructed directly in the storage and called through a single function pointer, so calling it costs the same
+   * as calling a plain handler with a void* argument. Functions are neither copyable nor movable, since handlers are
+   * registered by address.
+   * @tparam arg_type The argument the callable is called with.
+   * @tparam storage_size The maximum size of the callable, in bytes.
+   */
+  template<typename arg_type, size_t storage_size>
+  class InplaceFunction {
+   public:
+    InplaceFunction() : _invoke(nullptr), _destroy(nullptr) {}
+    ~InplaceFunction() { reset(); }
+    InplaceFunction(const InplaceFunction&) = delete;
+    InplaceFunction& operator=(const InplaceFunction&) = delete;
+
+    /**
+     * @brief Check if a callable can be stored.
+     * @tparam callable_type The callable type.
+     */
+    template<typename callable_type>
+    static constexpr bool fits() {
+      return sizeof(callable_type) <= storage_size && alignof(callable_type) <= alignof(std::max_align_t);
+    }
+
+    /**
+     * @brief Construct a callable in the storage, replacing the current one.
+     * @param callable The callable to store.
+     */
+    template<typename callable_type>
+    void emplace(callable_type&& callable) {
+      using stored_type = std::decay_t<callable_type>;
+      static_assert(fits<stored_type>(), "Handler captures exceed CONFIG_ESP_BE_HANDLER_CAPTURE_WORDS.");
+      static_assert(std::is_invocable_v<stored_type&, arg_type>, "Handlers must be callable with the event.");
+      reset();
+      new(_storage) stored_type(std::forward<callable_type>(callable));
+      _invoke = [](void* storage, arg_type arg) { (*static_cast<stored_type*>(storage))(arg); };
+      _destroy = nullptr;
+      if constexpr(!std::is_trivially_destructible_v<stored_type>) {
+        _destroy = [](void* storage) { static_cast<stored_type*>(storage)->~stored_type(); };
+      }
+    }
+
+    /**
+     * @brief Destroy the stored callable.
+     */
+    void reset() {
+      if(_destroy) {
+        _destroy(_storage);
+      }
+      _invoke = nullptr;
+      _destroy = nullptr;
+    }
+
+    /**
+     * @brief Check if a callable is stored.
+     */
+    explicit operator bool() const { return _invoke; }
+
+    /**
+     * @brief Call the stored callable. A callable must be stored.
+     * @param arg The argument to call it with.
+     */
+    void operator()(arg_type arg) { _invoke(_storage, arg); }
+
+   private:
+    alignas(std::max_align_t) unsigned char _storage[storage_size];
+    void (*_invoke)(void* storage, arg_type arg);
+    void (*_destroy)(void* storage);
+  };
+}  // namespace ButtonEvents
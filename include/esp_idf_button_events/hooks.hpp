@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_idf_button_events/platform.hpp"
+
+namespace ButtonEvents {
+  /**
+   * @brief Timeline hooks at each point of the event pipeline, forwarded to a pluggable sink.
+   * @details Enabled with CONFIG_ESP_BE_HOOKS. When disabled the hooks are empty inline functions and compile out.
+   * Records are passed to the sink synchronously, from the context of the hook point, which includes the GPIO ISR
+   * and the esp_timer task. Sinks must be short, non blocking and safe to call from an ISR, and placed in IRAM with
+   * CONFIG_ESP_BE_ISR_IN_IRAM. On target a sink would typically forward records to SEGGER SystemView or app_trace.
+   * The host build provides FileSink, which writes a timeline viewable in Perfetto or chrome://tracing.
+   */
+  namespace Hooks {
+    /**
+     * @brief Points in the pipeline at which records are emitted.
+     */
+    enum class Point : uint8_t {
+      ISR,             ///< Pin edge ISR entry. Value is unused.
+      DEBOUNCE_TIMER,  ///< Debounce timer callback. Value is the debounced State.
+      HELD_TIMER,      ///< Held timer callback. Value is unused.
+      WAKE_BEGIN,      ///< Event manager task woke. Button is no_button, value is the number of triggers.
+      DECODE,          ///< A trigger decoded by the event manager. Value is the trigger, 1 edge, 2 debounce, 4 repeat.
+      WAKE_END,        ///< Event manager task finished handling a wake. Button is no_button.
+      POST,            ///< Event posted to the event loop. Value is the EventType.
+      DISPATCH,        ///< Event dispatch started on the event loop task. Value is the EventType.
+    };
+
+    constexpr uint8_t no_button = 0xFF;
+
+    /**
+     * @brief A record emitted at a hook point.
+     */
+    struct Record {
+      uint64_t time;   ///< Time of the record, in us.
+      Point point;     ///< The hook point.
+      uint8_t button;  ///< The button index, or no_button.
+      uint8_t value;   ///< Point specific value.
+    };
+
+    /**
+     * @brief Sink receiving hook records.
+     * @param record The record.
+     * @param arg The argument given to set_sink.
+     */
+    using Sink = void (*)(const Record& record, void* arg);
+
+#ifdef CONFIG_ESP_BE_HOOKS
+    /**
+     * @brief Set the sink receiving hook records. Set it before creating buttons, it isn't synchronised with hooks
+     *        which are running.
+     * @param sink The sink, or nullptr to discard records.
+     * @param arg An argument passed to the sink.
+     */
+    void set_sink(Sink sink, void* arg);
+#endif
+  }  // namespace Hooks
+}  // namespace ButtonEvents
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_idf_button_events/platform.hpp"
+
+namespace ButtonEvents {
+  /**
+   * @brief Latency histograms of the stages of the event pipeline, per button.
+   * @details Enabled with CONFIG_ESP_BE_LATENCY_HISTOGRAMS. Each event is timestamped as it passes through the
+   * pipeline, and the time spent in each stage is counted in a log2 bucket. Histograms are read with
+   * Button::latency(). When disabled, no timestamps are taken and no memory is used.
+   */
+  namespace Latency {
+    /**
+     * @brief Pipeline stages. Stages are measured for BUTTON_DOWN and BUTTON_UP events, except QUEUE which is
+     *        measured for all events.
+     */
+    enum class Stage {
+      DEBOUNCE,  ///< First edge ISR to debounce timer expiry.
+      TIMER,     ///< Debounce timer expiry to classification on the manager task.
+      CLASSIFY,  ///< Classification to the event post.
+      QUEUE,     ///< Event post to handler entry, including any time blocked on a full event loop queue.
+      TOTAL,     ///< First edge ISR to handler entry.
+    };
+
+    constexpr size_t stage_count = 5;
+    constexpr size_t bucket_count = 20;
+
+    /**
+     * @brief Get the bucket a duration is counted in.
+     * @details Bucket 0 holds durations below 2us. Bucket n holds durations from 2^n us up to 2^(n+1) us.
+     * The last bucket holds all longer durations.
+     * @param us The duration in us.
+     * @return constexpr size_t The bucket index.
+     */
+    constexpr size_t bucket(uint64_t us) {
+      size_t b = 0;
+      while(us >>= 1) {
+        b++;
+      }
+      return b < bucket_count ? b : bucket_count - 1;
+    }
+
+    /**
+     * @brief A snapshot of a latency histogram.
+     */
+    struct Histogram {
+      std::array<uint32_t, bucket_count> counts;  ///< Number of samples in each bucket.
+
+      /**
+       * @brief Get the total number of samples.
+       * @return uint32_t
+       */
+      uint32_t count() const {
+        uint32_t total = 0;
+        for(auto c: counts) {
+          total += c;
+        }
+        return total;
+      }
+
+      /**
+       * @brief Get an upper bound of a percentile.
+       * @param p The percentile, from 0 to 1.
+       * @return uint64_t The upper limit of the bucket holding the percentile in us, or 0 without samples.
+       */
+      uint64_t percentile_us(const double p) const {
+        auto target = p * count();
+        uint32_t seen = 0;
+        for(size_t b = 0; b < bucket_count; b++) {
+          seen += counts[b];
+          if(counts[b] && seen >= target) {
+            return (uint64_t(1) << (b + 1)) - 1;
+          }
+        }
+        return 0;
+      }
+    };
+
+#ifdef CONFIG_ESP_BE_LATENCY_HISTOGRAMS
+    /**
+     * @brief Reset the histograms of all buttons.
+     */
+    void reset();
+#endif
+  }  // namespace Latency
+}  // namespace ButtonEvents
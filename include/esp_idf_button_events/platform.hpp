@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+
+#include "sdkconfig.h"
+
+#if defined(ESP_PLATFORM)
+  #include <driver/gpio.h>
+  #include <esp_log.h>
+  #include <esp_timer.h>
+  #include <freertos/FreeRTOS.h>
+  #include <freertos/event_groups.h>
+  #include <freertos/queue.h>
+  #include <freertos/task.h>
+  #include <freertos/timers.h>
+
+  #include "esp_event.h"
+  #include "esp_system.h"
+#else
+  // Minimal stand-ins for the ESP-IDF types used by the public interface, so the component builds off target.
+  #include <cstdio>
+
+  #define IRAM_ATTR
+  #define ESP_LOGW(tag, format, ...) std::fprintf(stderr, "W %s: " format "\n", tag, ##__VA_ARGS__)
+
+  #define ESP_EVENT_ANY_BASE NULL
+  #define ESP_EVENT_ANY_ID   -1
+
+  #define ESP_EVENT_DECLARE_BASE(id) extern esp_event_base_t const id
+  #define ESP_EVENT_DEFINE_BASE(id)  esp_event_base_t const id = #id
+
+typedef const char* esp_event_base_t;
+typedef void* esp_event_handler_instance_t;
+typedef void (*esp_event_handler_t)(void* event_handler_arg, esp_event_base_t event_base, int32_t event_id, void* event_data);
+
+typedef enum {
+  GPIO_NUM_NC = -1,
+  GPIO_NUM_0 = 0,
+  GPIO_NUM_1,
+  GPIO_NUM_2,
+  GPIO_NUM_3,
+  GPIO_NUM_4,
+  GPIO_NUM_5,
+  GPIO_NUM_6,
+  GPIO_NUM_7,
+  GPIO_NUM_8,
+  GPIO_NUM_9,
+  GPIO_NUM_10,
+  GPIO_NUM_11,
+  GPIO_NUM_12,
+  GPIO_NUM_13,
+  GPIO_NUM_14,
+  GPIO_NUM_15,
+  GPIO_NUM_16,
+  GPIO_NUM_17,
+  GPIO_NUM_18,
+  GPIO_NUM_19,
+  GPIO_NUM_20,
+  GPIO_NUM_21,
+  GPIO_NUM_22,
+  GPIO_NUM_23,
+  GPIO_NUM_24,
+  GPIO_NUM_25,
+  GPIO_NUM_26,
+  GPIO_NUM_27,
+  GPIO_NUM_28,
+  GPIO_NUM_29,
+  GPIO_NUM_30,
+  GPIO_NUM_31,
+  GPIO_NUM_32,
+  GPIO_NUM_33,
+  GPIO_NUM_34,
+  GPIO_NUM_35,
+  GPIO_NUM_36,
+  GPIO_NUM_37,
+  GPIO_NUM_38,
+  GPIO_NUM_39,
+  GPIO_NUM_MAX,
+} gpio_num_t;
+#endif
+
+namespace Hal {
+#if defined(ESP_PLATFORM)
+  using TimerHandle = esp_timer_handle_t;
+  using SignalHandle = EventGroupHandle_t;
+  using QueueHandle = QueueHandle_t;
+#else
+  struct Timer;
+  struct Signal;
+  struct Queue;
+  using TimerHandle = Timer*;
+  using SignalHandle = Signal*;
+  using QueueHandle = Queue*;
+#endif
+}  // namespace Hal
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "esp_idf_button_events/button.hpp"
+
+#ifdef CONFIG_ESP_BE_EVENT_RING
+
+namespace ButtonEvents {
+  /**
+   * @brief A fixed size ring of event records with one writer, the event manager task, and any number of readers.
+   * @details Each reader holds its own cursor and copies records out of the ring at its own pace, without locks. The
+   * writer never waits for readers: once the ring is full the oldest record is overwritten. Each slot holds the
+   * position of the record last written to it, so a reader which fell more than a ring behind, or which races with
+   * the overwrite of the record it is copying, skips to the oldest record still held and counts the records it lost.
+   *
+   * Positions are 32 bit and compared modulo 2^32, so readers must not fall more than 2^31 records behind.
+   */
+  class EventRing {
+   public:
+    static constexpr size_t size = CONFIG_ESP_BE_EVENT_RING_SIZE;
+    static_assert(size && !(size & (size - 1)), "CONFIG_ESP_BE_EVENT_RING_SIZE must be a power of two.");
+
+    /**
+     * @brief A cursor into the ring, owned by a single consuming task, reading the records of a mask of events.
+     * @code
+     * auto reader = ButtonEvents::ring_reader();
+     * EventRecord record;
+     * while(true) {
+     *   while(reader.next(record)) {
+     *     ui_update(EventView(&record));
+     *   }
+     *   vTaskDelay(pdMS_TO_TICKS(20));
+     * }
+     * @endcode
+     */
+    class Reader {
+     public:
+      /**
+       * @brief Construct a reader which reads records written from now on.
+       * @param ring The ring to read.
+       * @param events A mask of the events to read, other records are skipped.
+       */
+      explicit Reader(const EventRing& ring, const uint32_t events = all_events())
+          : _ring(&ring), _events(events), _cursor(ring._head.load(std::memory_order_acquire)), _lost(0) {}
+
+      /**
+       * @brief Copy the next record of the reader's events, oldest first.
+       * @param record Set to the record.
+       * @return true A record was read.
+       * @return false The reader has caught up with the writer.
+       */
+      bool next(EventRecord& record) {
+        while(true) {
+          auto head = _ring->_head.load(std::memory_order_acquire);
+          auto behind = head - _cursor;
+          if(!behind) {
+            return false;
+          }
+          if(behind > size) {
+            _lost += behind - size;
+            _cursor = head - size;
+          }
+          if(_ring->_read(_cursor, record)) {
+            _cursor++;
+            if(_events & event_mask(record.event)) {
+              return true;
+            }
+            continue;
+          }
+          // Overwritten while it was copied, the record is lost.
+          _lost++;
+          _cursor++;
+        }
+      }
+
+      /**
+       * @brief Get the number of records of the reader's events held by the ring and not yet read. Takes time
+       *        proportional to the number of records written since the last read, up to the ring size.
+       * @return uint32_t
+       */
+      uint32_t pending() const {
+        auto head = _ring->_head.load(std::memory_order_acquire);
+        auto position = head - _cursor > size ? head - size : _cursor;
+        uint32_t count = 0;
+        EventRecord record;
+        for(; position != head; position++) {
+          count += _ring->_read(position, record) && (_events & event_mask(record.event));
+        }
+        return count;
+      }
+
+      /**
+       * @brief Get the number of records overwritten before this reader could read them. Their events are unknown, so
+       *        records of other events are counted too.
+       * @return uint32_t
+       */
+      uint32_t lost() const { return _lost; }
+
+     private:
+      const EventRing* _ring;
+      uint32_t _events;
+      uint32_t _cursor;
+      uint32_t _lost;
+    };
+
+    EventRing() : _head(0), _slots{} {}
+    EventRing(const EventRing&) = delete;
+    EventRing& operator=(const EventRing&) = delete;
+
+    /**
+     * @brief Write a record, overwriting the oldest once the ring is full. Only called by the writer task.
+     * @param record The record.
+     */
+    void publish(const EventRecord& record) {
+      auto position = _head.load(std::memory_order_relaxed);
+      auto& slot = _slots[position & (size - 1)];
+      // Marks the slot with its new position before rewriting the words, so readers copying the old record see it
+      // changed. Readers of the new position only read it once the head is published.
+      slot.position.store(position, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      uint32_t words[word_count];
+      std::memcpy(words, &record, sizeof(record));
+      for(size_t i = 0; i < word_count; i++) {
+        slot.words[i].store(words[i], std::memory_order_relaxed);
+      }
+      _head.store(position + 1, std::memory_order_release);
+    }
+
+   private:
+    static constexpr size_t word_count = sizeof(EventRecord) / sizeof(uint32_t);
+    static_assert(sizeof(EventRecord) % sizeof(uint32_t) == 0, "Event records are copied as 32 bit words.");
+
+    /**
+     * @brief A record, held as words so concurrent copies are well defined.
+     */
+    struct Slot {
+      std::atomic<uint32_t> position;
+      std::array<std::atomic<uint32_t>, word_count> words;
+    };
+
+    bool _read(const uint32_t position, EventRecord& record) const {
+      auto& slot = _slots[position & (size - 1)];
+      if(slot.position.load(std::memory_order_acquire) != position) {
+        return false;
+      }
+      uint32_t words[word_count];
+      for(size_t i = 0; i < word_count; i++) {
+        words[i] = slot.words[i].load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if(slot.position.load(std::memory_order_relaxed) != position) {
+        return false;
+      }
+      std::memcpy(&record, words, sizeof(record));
+      return true;
+    }
+
+    std::atomic<uint32_t> _head;
+    std::array<Slot, size> _slots;
+  };
+
+  /**
+   * @brief Get a reader of the event ring of the default event manager, starting at the next event.
+   * @details Events in the mask are written to the ring for all buttons of the default manager, including those
+   * created later, whether or not they have handlers. Events written to the ring are not posted to the event loop
+   * unless handlers are added for them.
+   * @param events A mask of the events to read, built with event_mask() or all_events(). The ring holds the events of
+   * all readers, each reader skips those outside its own mask.
+   * @return EventRing::Reader
+   */
+  EventRing::Reader ring_reader(const uint32_t events = all_events());
+}  // namespace ButtonEvents
+
+#endif
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_idf_button_events/button.hpp"
+
+namespace ButtonEvents {
+  /**
+   * @brief Snapshot of the event manager runtime statistics, enabled with CONFIG_ESP_BE_STATS.
+   * @details Counters are updated with relaxed atomics, so a snapshot taken while events are being processed
+   * may be slightly inconsistent between counters.
+   */
+  struct Stats {
+    /**
+     * @brief Statistics of a single button.
+     */
+    struct ButtonStats {
+      const Button* button;  ///< The button, or nullptr for unused slots.
+      uint32_t edges;        ///< Pin edges seen by the ISR, including bounces.
+      uint32_t spurious;     ///< Debounced transitions which read the same state as the previous transition.
+    };
+
+    uint32_t wakes;                                 ///< Number of times the event manager task woke.
+    uint32_t decoded;                               ///< Button triggers decoded, over all wakes.
+    uint32_t max_decoded_per_wake;                  ///< The most button triggers decoded in a single wake.
+    std::array<uint32_t, event_type_count> posted;  ///< Events posted, indexed by EventType.
+    uint32_t blocked_posts;                         ///< Posts which waited for space in the event loop queue.
+    uint64_t blocked_us;                            ///< Total time spent waiting for space in the event loop queue.
+    uint32_t max_blocked_us;                        ///< The longest wait for space in the event loop queue.
+    uint32_t queue_high_watermark;                  ///< The most events posted and not yet dispatched.
+    uint32_t queue_drops;                           ///< Events not sent to a full handler queue.
+    uint32_t manager_stack_free;                    ///< Event manager task stack high watermark in bytes, 0 if unknown.
+    uint32_t loop_stack_free;                       ///< Event loop task stack high watermark in bytes, 0 if unknown.
+    std::array<ButtonStats, CONFIG_ESP_BE_MAX_BUTTON_COUNT> buttons;  ///< Per button statistics, by creation order.
+  };
+
+#ifdef CONFIG_ESP_BE_STATS
+  /**
+   * @brief Get a snapshot of the default event manager runtime statistics. Button statistics only cover its buttons,
+   *        the slots of buttons bound to other managers are empty.
+   * @return Stats
+   */
+  Stats stats();
+
+  /**
+   * @brief Reset all counters and the queue high watermark to zero. Stack high watermarks cover the lifetime of
+   *        the tasks and are not reset.
+   */
+  void reset_stats();
+#endif
+}  // namespace ButtonEvents
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "esp_idf_button_events/button.hpp"
+
+namespace ButtonEvents {
+  /**
+   * @brief Recording of raw pin edges and emitted events, for offline replay.
+   * @details When CONFIG_ESP_BE_TRACE is enabled, every pin edge seen by a button ISR and every event posted is
+   * appended to a fixed size ring buffer, overwriting the oldest records when full. A dump of the ring together with
+   * the configuration of each button can be replayed on the host through the same classification code with
+   * the replay_trace tool.
+   *
+   * Dump layout, little endian:
+   * - Magic "BET2".
+   * - Button count, followed by a ButtonConfig for each button (1 + 1 + 5 * 4 + 1 bytes).
+   * - Time of the oldest record, in us (8 bytes).
+   * - Records. Each record is a header byte followed by the time since the previous record as an unsigned LEB128.
+   *   The header holds the record kind in bit 7, the button index in bits 6-4 and the level or event type in bits 3-0.
+   */
+  namespace Trace {
+    /**
+     * @brief Configuration of a traced button, needed to replay its edges.
+     */
+    struct ButtonConfig {
+      uint8_t index;            ///< The button index, used by records.
+      bool inverted;            ///< If true, high = pressed.
+      uint32_t debounce_us;     ///< Debounce time.
+      uint32_t short_press_us;  ///< Short press time.
+      uint32_t long_press_us;   ///< Long press time.
+      uint32_t hold_press_us;   ///< Time before the first held event.
+      uint32_t hold_repeat_us;  ///< Time between held events.
+      uint8_t events;           ///< Mask of the subscribed events, the only events recorded and classified as held.
+    };
+
+    /**
+     * @brief A decoded trace record.
+     */
+    struct Record {
+      uint64_t time;    ///< Time of the record, in us.
+      uint8_t button;   ///< The button index.
+      bool is_event;    ///< True for an emitted event, false for a pin edge.
+      bool level;       ///< The raw pin level after the edge. Only valid for edges.
+      EventType event;  ///< The emitted event. Only valid for events.
+    };
+
+    constexpr uint8_t magic[] = {'B', 'E', 'T', '2'};
+    constexpr size_t button_config_size = 2 + 5 * sizeof(uint32_t) + 1;
+    /**
+     * @brief Version of dumps without subscription masks, read as subscribed to all events.
+     */
+    constexpr uint8_t version_1 = '1';
+    constexpr size_t button_config_size_1 = 2 + 5 * sizeof(uint32_t);
+    constexpr uint8_t event_record = 0x80;
+    constexpr size_t max_record_size = 1 + 10;  ///< Header and the longest 64 bit LEB128.
+    constexpr uint8_t record_header(const bool is_event, const size_t button, const uint8_t value) {
+      return (is_event ? event_record : 0) | static_cast<uint8_t>((button & 0x7) << 4) | (value & 0xF);
+    }
+    static_assert(CONFIG_ESP_BE_MAX_BUTTON_COUNT <= 8, "Trace records hold 3 bit button indices.");
+
+    /**
+     * @brief Decodes a trace dump. The dump is not copied, and must outlive the reader.
+     */
+    class Reader {
+     public:
+      /**
+       * @brief Construct a reader and decode the dump header.
+       * @param data The dump.
+       * @param size The size of the dump, in bytes.
+       */
+      Reader(const uint8_t* data, const size_t size) : _data(data), _size(size), _position(0), _time(0), _start(0), _buttons(0), _valid(false) {
+        if(_size < sizeof(magic) + 1 || std::memcmp(_data, magic, sizeof(magic) - 1)) {
+          return;
+        }
+        auto version = _data[sizeof(magic) - 1];
+        if(version != magic[sizeof(magic) - 1] && version != version_1) {
+          return;
+        }
+        auto config_size = version == version_1 ? button_config_size_1 : button_config_size;
+        _position = sizeof(magic);
+        _buttons = _data[_position++];
+        if(_buttons > CONFIG_ESP_BE_MAX_BUTTON_COUNT || _size < _position + _buttons * config_size + sizeof(uint64_t)) {
+          return;
+        }
+        for(size_t i = 0; i < _buttons; i++) {
+          auto& c = _configs[i];
+          c.index = _data[_position++];
+          c.inverted = _data[_position++];
+          c.debounce_us = _read_fixed(sizeof(uint32_t));
+          c.short_press_us = _read_fixed(sizeof(uint32_t));
+          c.long_press_us = _read_fixed(sizeof(uint32_t));
+          c.hold_press_us = _read_fixed(sizeof(uint32_t));
+          c.hold_repeat_us = _read_fixed(sizeof(uint32_t));
+          c.events = version == version_1 ? all_events() : _data[_position++];
+        }
+        _start = _time = _read_fixed(sizeof(uint64_t));
+        _valid = true;
+      }
+
+      /**
+       * @brief Check if the dump header was decoded.
+       * @return true The dump is valid.
+       * @return false The dump is truncated or not a trace dump.
+       */
+      bool valid() const { return _valid; }
+
+      /**
+       * @brief Get the number of buttons in the dump.
+       * @return size_t
+       */
+      size_t button_count() const { return _buttons; }
+
+      /**
+       * @brief Get the configuration of a button.
+       * @param i The position of the button in the dump, less than button_count().
+       * @return const ButtonConfig&
+       */
+      const ButtonConfig& button(const size_t i) const { return _configs[i]; }
+
+      /**
+       * @brief Get the time of the oldest record.
+       * @return uint64_t Time in us.
+       */
+      uint64_t start_time() const { return _start; }
+
+      /**
+       * @brief Decode the next record.
+       * @param record Set to the decoded record.
+       * @return true A record was decoded.
+       * @return false There are no more records.
+       */
+      bool next(Record& record) {
+        if(!_valid || _position >= _size) {
+          return false;
+        }
+        auto header = _data[_position++];
+        uint64_t delta = 0;
+        for(size_t shift = 0; _position < _size && shift < 64; shift += 7) {
+          auto byte = _data[_position++];
+          delta |= static_cast<uint64_t>(byte & 0x7F) << shift;
+          if(!(byte & 0x80)) {
+            break;
+          }
+        }
+        _time += delta;
+        record.time = _time;
+        record.button = (header >> 4) & 0x7;
+        record.is_event = header & event_record;
+        record.level = header & 0x1;
+        record.event = static_cast<EventType>(header & 0xF);
+        return true;
+      }
+
+     private:
+      uint64_t _read_fixed(const size_t bytes) {
+        uint64_t value = 0;
+        for(size_t i = 0; i < bytes; i++) {
+          value |= static_cast<uint64_t>(_data[_position++]) << (8 * i);
+        }
+        return value;
+      }
+
+      const uint8_t* _data;
+      size_t _size;
+      size_t _position;
+      uint64_t _time;
+      uint64_t _start;
+      size_t _buttons;
+      bool _valid;
+      ButtonConfig _configs[CONFIG_ESP_BE_MAX_BUTTON_COUNT];
+    };
+
+#ifdef CONFIG_ESP_BE_TRACE
+    /**
+     * @brief Get the number of bytes needed to dump the trace.
+     * @return size_t Size in bytes. May grow before dump() is called, if new records are added.
+     */
+    size_t dump_size();
+
+    /**
+     * @brief Copy the configuration of all traced buttons and all records in the ring to a buffer.
+     * @param buffer The buffer to write to.
+     * @param size The size of the buffer, in bytes.
+     * @return size_t The number of bytes written, or 0 if the buffer is too small.
+     */
+    size_t dump(uint8_t* buffer, const size_t size);
+
+    /**
+     * @brief Discard all records. Button configurations are kept.
+     */
+    void clear();
+#endif
+  }  // namespace Trace
+}  // namespace ButtonEvents
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_idf_button_events/button.hpp"
+
+namespace ButtonEvents {
+  /**
+   * @brief Execution time watchdog of handlers added with Button::add_handler().
+   * @details Enabled with CONFIG_ESP_BE_HANDLER_WATCHDOG, for buttons on the default event manager. Each handler is
+   * timed as it is called from the event loop task. A handler running longer than the budget delays the events of
+   * every button, so each overrun is logged, counted and passed to an optional callback, identifying the button, event
+   * and handler.
+   */
+  namespace Watchdog {
+    /**
+     * @brief A handler call which ran over budget.
+     */
+    struct Overrun {
+      const Button* button;         ///< The button the handler was added to.
+      EventType event;              ///< The event the handler was added for.
+      esp_event_handler_t handler;  ///< The handler.
+      void* arg;                    ///< The handler argument.
+      uint32_t duration_us;         ///< How long the handler ran.
+      uint32_t budget_us;           ///< The budget at the time of the call.
+    };
+
+    /**
+     * @brief Timing statistics of a single handler.
+     */
+    struct HandlerStats {
+      const Button* button;         ///< The button the handler was added to.
+      EventType event;              ///< The event the handler was added for.
+      esp_event_handler_t handler;  ///< The handler.
+      uint32_t calls;               ///< Number of calls.
+      uint32_t overruns;            ///< Number of calls which ran over budget.
+      uint32_t max_us;              ///< The longest call.
+    };
+
+    /**
+     * @brief Called on the event loop task after a handler ran over budget.
+     * @param overrun The overrun.
+     * @param arg The argument given to set_callback.
+     */
+    using Callback = void (*)(const Overrun& overrun, void* arg);
+
+#ifdef CONFIG_ESP_BE_HANDLER_WATCHDOG
+    /**
+     * @brief Set the handler execution time budget. Defaults to CONFIG_ESP_BE_HANDLER_BUDGET_US.
+     * @param budget_us The budget in us.
+     */
+    void set_budget_us(const uint32_t budget_us);
+
+    /**
+     * @brief Set a callback called on each overrun, in addition to the log. Can be changed while handlers run, the
+     *        callback is always called with its own argument.
+     * @param callback The callback, or nullptr for none.
+     * @param arg An argument passed to the callback.
+     */
+    void set_callback(Callback callback, void* arg);
+
+    /**
+     * @brief Get the number of timed handlers.
+     * @return size_t
+     */
+    size_t handler_count();
+
+    /**
+     * @brief Get the timing statistics of a handler.
+     * @param index The handler index, in the order handlers were added, less than handler_count().
+     * @return HandlerStats
+     */
+    HandlerStats handler_stats(const size_t index);
+#endif
+  }  // namespace Watchdog
+}  // namespace ButtonEvents
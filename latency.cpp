@@ -0,0 +1,84 @@
+#include "latency_recorder.hpp"
+
+#ifdef CONFIG_ESP_BE_LATENCY_HISTOGRAMS
+
+  #include <atomic>
+
+  #include "hal.hpp"
+
+namespace ButtonEvents::Latency {
+  namespace {
+    /**
+     * @brief Timestamps of the transition in progress for a button. Zero when not set.
+     */
+    struct Timestamps {
+      uint64_t edge;
+      uint64_t debounced;
+      uint64_t classified;
+      uint64_t origin;  ///< Edge time of the last classified transition, used for the total.
+    };
+
+    std::array<Timestamps, CONFIG_ESP_BE_MAX_BUTTON_COUNT> timestamps = {};
+    std::array<std::array<std::array<std::atomic<uint32_t>, bucket_count>, stage_count>, CONFIG_ESP_BE_MAX_BUTTON_COUNT> histograms = {};
+
+    void add(const size_t button, const Stage stage, const uint64_t from, const uint64_t to) {
+      if(from && to >= from) {
+        histograms[button][static_cast<size_t>(stage)][bucket(to - from)].fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+
+    bool edge_event(const EventType event) { return event == EventType::BUTTON_DOWN || event == EventType::BUTTON_UP; }
+  }  // namespace
+
+  void IRAM_ATTR edge(const size_t button) {
+    // Further edges are bounces of the same transition, until it is classified.
+    if(!timestamps[button].edge) {
+      timestamps[button].edge = Hal::time_us();
+    }
+  }
+
+  void debounced(const size_t button) { timestamps[button].debounced = Hal::time_us(); }
+
+  void classified(const size_t button) {
+    auto& t = timestamps[button];
+    t.classified = Hal::time_us();
+    add(button, Stage::DEBOUNCE, t.edge, t.debounced);
+    add(button, Stage::TIMER, t.debounced, t.classified);
+    t.origin = t.edge;
+    t.edge = 0;
+  }
+
+  void posted(const size_t button, const EventType event, const uint64_t timestamp) {
+    if(edge_event(event)) {
+      add(button, Stage::CLASSIFY, timestamps[button].classified, timestamp);
+    }
+  }
+
+  void entered(const size_t button, const EventType event, const uint64_t timestamp) {
+    auto now = Hal::time_us();
+    add(button, Stage::QUEUE, timestamp, now);
+    if(edge_event(event)) {
+      add(button, Stage::TOTAL, timestamps[button].origin, now);
+    }
+  }
+
+  Histogram histogram(const size_t button, const Stage stage) {
+    Histogram h;
+    for(size_t b = 0; b < bucket_count; b++) {
+      h.counts[b] = histograms[button][static_cast<size_t>(stage)][b].load(std::memory_order_relaxed);
+    }
+    return h;
+  }
+
+  void reset() {
+    for(auto& button: histograms) {
+      for(auto& stage: button) {
+        for(auto& count: stage) {
+          count.store(0, std::memory_order_relaxed);
+        }
+      }
+    }
+  }
+}  // namespace ButtonEvents::Latency
+
+#endif
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <esp_idf_button_events/button.hpp>
+#include <esp_idf_button_events/latency.hpp>
+
+#ifdef CONFIG_ESP_BE_LATENCY_HISTOGRAMS
+
+/**
+ * @brief Internal timestamping of events as they pass through the pipeline. Histograms are read through
+ *        Button::latency().
+ */
+namespace ButtonEvents::Latency {
+  /**
+   * @brief Record the first edge of a transition. Safe to call from an ISR.
+   * @param button The button index.
+   */
+  void edge(const size_t button);
+
+  /**
+   * @brief Record the expiry of the debounce timer.
+   * @param button The button index.
+   */
+  void debounced(const size_t button);
+
+  /**
+   * @brief Record the classification of a debounced transition on the manager task.
+   * @param button The button index.
+   */
+  void classified(const size_t button);
+
+  /**
+   * @brief Record an event post.
+   * @param button The button index.
+   * @param event The event type.
+   * @param timestamp The event timestamp, which is the time of the post.
+   */
+  void posted(const size_t button, const EventType event, const uint64_t timestamp);
+
+  /**
+   * @brief Record handler entry. Called from a handler registered for all events on the event loop, which runs
+   *        before the handlers of a particular button or event.
+   * @param button The button index.
+   * @param event The event type.
+   * @param timestamp The event timestamp, which is the time of the post.
+   */
+  void entered(const size_t button, const EventType event, const uint64_t timestamp);
+
+  /**
+   * @brief Get a snapshot of a histogram.
+   * @param button The button index.
+   * @param stage The pipeline stage.
+   * @return Histogram
+   */
+  Histogram histogram(const size_t button, const Stage stage);
+}  // namespace ButtonEvents::Latency
+
+#endif
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <esp_idf_button_events/platform.hpp>
+
+/**
+ * @brief Control of the virtual time simulator behind the Linux HAL implementation.
+ * @details The simulator is single threaded and deterministic. Pin edges call ISRs immediately, after
+ * which runnable services and event loop tasks are run in priority order. Timers fire as virtual time is
+ * advanced. Nothing runs between calls into the simulator.
+ *
+ * A handler which calls set_level() or advance() models a task blocking part way through. Other services and
+ * loop tasks run meanwhile, as they would on other cores or at higher priority, but the caller's own task does not.
+ */
+namespace Sim {
+  /**
+   * @brief Get the current virtual time.
+   * @return uint64_t Time in microseconds.
+   */
+  uint64_t now();
+
+  /**
+   * @brief Drive a pin to a logic level. On a change of level the pin ISR is called, if attached,
+   *        followed by any work which became runnable.
+   * @param pin The pin to drive.
+   * @param level The level to drive.
+   */
+  void set_level(gpio_num_t pin, bool level);
+
+  /**
+   * @brief Schedule a pin level change at a later time. Scheduled levels are driven as virtual time is advanced,
+   *        and while code busy waits with Hal::delay_us(), which lets ISRs see short glitches.
+   * @param pin The pin to drive.
+   * @param level The level to drive.
+   * @param time The absolute time to drive the level at, in microseconds.
+   */
+  void set_level_at(gpio_num_t pin, bool level, uint64_t time);
+
+  /**
+   * @brief Get the level of a pin.
+   * @param pin The pin to read.
+   * @return true The pin is high.
+   * @return false The pin is low.
+   */
+  bool level(gpio_num_t pin);
+
+  /**
+   * @brief Run all work which is runnable at the current time, without advancing time.
+   */
+  void run();
+
+  /**
+   * @brief Advance virtual time, firing timers and running work as it becomes due.
+   * @param us The time to advance by, in microseconds.
+   */
+  void advance(uint64_t us);
+
+  /**
+   * @brief Advance virtual time to an absolute time. Times in the past are ignored.
+   * @param time The time to advance to, in microseconds.
+   */
+  void advance_to(uint64_t time);
+
+  /**
+   * @brief Advance virtual time without running anything, modelling CPU time spent by the caller. Can be called from
+   *        handlers and callbacks. Timers which become due fire on the next call to run() or advance().
+   * @param us The time spent, in microseconds.
+   */
+  void spend(uint64_t us);
+
+  /**
+   * @brief Get the time of the next pending timer or service timeout.
+   * @return uint64_t The time in microseconds, or UINT64_MAX if nothing is pending.
+   */
+  uint64_t next_deadline();
+
+  /**
+   * @brief Counters collected by the simulator, used for benchmarking.
+   */
+  struct Stats {
+    uint64_t service_wakes;       ///< Number of times a service was woken.
+    uint64_t service_cpu_ns;      ///< Host CPU time spent in service wake handlers, in ns.
+    uint64_t loop_posts;          ///< Number of events posted to event loops.
+    uint64_t loop_blocked_posts;  ///< Number of posts which found the loop queue full and had to wait.
+    uint64_t loop_dispatches;     ///< Number of events dispatched from event loops.
+    uint64_t loop_cpu_ns;         ///< Host CPU time spent dispatching events to handlers, in ns.
+    size_t loop_peak_depth;       ///< The maximum number of events queued on a loop.
+  };
+
+  /**
+   * @brief Get the simulator counters.
+   * @return Stats
+   */
+  Stats stats();
+
+  /**
+   * @brief Reset the simulator counters to zero.
+   */
+  void reset_stats();
+}  // namespace Sim
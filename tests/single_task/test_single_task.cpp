@@ -0,0 +1,75 @@
+#include <esp_idf_button_events/button.hpp>
+#include <string>
+#include <vector>
+
+#include "doctest.h"
+#include "event_manager.hpp"
+#include "sim.hpp"
+#include "test_helpers.hpp"
+
+using namespace ButtonEvents;
+using namespace TestHelpers;
+
+namespace {
+  struct Call {
+    std::string handler;
+    EventType event;
+    uint64_t time;
+    uint64_t timestamp;
+    bool operator==(const Call&) const = default;
+  };
+
+  std::vector<Call> calls;
+
+  void record(void* handler_args, esp_event_base_t base, int32_t id, void* event_data) {
+    auto event = EventView(event_data);
+    calls.push_back({static_cast<const char*>(handler_args), event.event(), Sim::now(), event.timestamp()});
+  }
+
+  constexpr uint32_t press_events =
+    event_mask(EventType::BUTTON_DOWN) | event_mask(EventType::BUTTON_UP) | event_mask(EventType::BUTTON_PRESS);
+
+  Button* button() {
+    return shared_button(GPIO_NUM_10, [] {
+      Button* b = Button::create("Single", GPIO_NUM_10).debounce_ms(20);
+      for(auto event: {EventType::BUTTON_DOWN, EventType::BUTTON_UP, EventType::BUTTON_PRESS}) {
+        b->add_handler(record, const_cast<char*>("loop"), event);
+        b->add_handler(record, const_cast<char*>("inline"), event, Context::INLINE);
+      }
+      Button::subscribe({b}, press_events, record, const_cast<char*>("subscription"));
+      return b;
+    });
+  }
+}  // namespace
+
+TEST_CASE("Single task mode dispatches each event before the next is classified") {
+  REQUIRE(event_loop_count() == 1);
+  button();
+  settle(GPIO_NUM_10);
+  calls.clear();
+  reset_stats();
+  press(GPIO_NUM_10);
+
+  // Subscriptions match any event id of the base, so the event loop calls them before id handlers.
+  std::vector<std::pair<std::string, EventType>> order;
+  for(auto& call: calls) {
+    order.push_back({call.handler, call.event});
+  }
+  CHECK(order == std::vector<std::pair<std::string, EventType>>{{"inline", EventType::BUTTON_DOWN},
+                                                                {"subscription", EventType::BUTTON_DOWN},
+                                                                {"loop", EventType::BUTTON_DOWN},
+                                                                {"inline", EventType::BUTTON_UP},
+                                                                {"subscription", EventType::BUTTON_UP},
+                                                                {"loop", EventType::BUTTON_UP},
+                                                                {"inline", EventType::BUTTON_PRESS},
+                                                                {"subscription", EventType::BUTTON_PRESS},
+                                                                {"loop", EventType::BUTTON_PRESS}});
+
+  // Handlers run on the manager task as the event is classified, so no event waits in the queue.
+  for(auto& call: calls) {
+    CHECK(call.time == call.timestamp);
+  }
+  auto s = stats();
+  CHECK(s.queue_high_watermark == 1);
+  CHECK(s.blocked_posts == 0);
+}
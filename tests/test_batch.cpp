@@ -0,0 +1,100 @@
+#include <esp_idf_button_events/button.hpp>
+#include <vector>
+
+#include "doctest.h"
+#include "sim.hpp"
+#include "test_helpers.hpp"
+
+using namespace ButtonEvents;
+using namespace TestHelpers;
+
+namespace {
+  struct Received {
+    size_t index;
+    EventType event;
+    bool operator==(const Received&) const = default;
+  };
+
+  struct Batches {
+    std::vector<std::vector<Received>> batches;
+    std::vector<uint64_t> times;
+    std::vector<int32_t> ids;
+  };
+
+  Batches wake_batches;
+  Batches window_batches;
+
+  void record(void* handler_args, esp_event_base_t base, int32_t id, void* event_data) {
+    auto& batches = *static_cast<Batches*>(handler_args);
+    REQUIRE(base == BUTTON_BATCH_EVENT);
+    std::vector<Received> batch;
+    for(auto& record: EventBatch(event_data)) {
+      batch.push_back({record.button, record.event});
+    }
+    auto events = EventBatch(event_data);
+    REQUIRE(events.size() > 0);
+    CHECK(events[events.size() - 1].event() == batch.back().event);
+    batches.batches.push_back(batch);
+    batches.times.push_back(Sim::now());
+    batches.ids.push_back(id);
+  }
+
+  Button* a() {
+    return shared_button(GPIO_NUM_26, [] { return Button::create("BA", GPIO_NUM_26).debounce_ms(20).short_press_ms(10); });
+  }
+
+  Button* b() {
+    return shared_button(GPIO_NUM_27, [] { return Button::create("BB", GPIO_NUM_27).debounce_ms(20).short_press_ms(10); });
+  }
+
+  constexpr uint32_t press_events =
+    event_mask(EventType::BUTTON_DOWN) | event_mask(EventType::BUTTON_UP) | event_mask(EventType::BUTTON_PRESS);
+}  // namespace
+
+TEST_CASE("Batches without a window hold the events of one wake") {
+  auto& received = wake_batches;
+  REQUIRE(Button::subscribe_batch({a()}, press_events, record, &received));
+  Sim::advance(1000 * ms);
+
+  press(GPIO_NUM_26);
+  REQUIRE(received.batches.size() == 2);
+  CHECK(received.batches[0] == std::vector<Received>{{a()->index(), EventType::BUTTON_DOWN}});
+  CHECK(received.batches[1] == std::vector<Received>{{a()->index(), EventType::BUTTON_UP}, {a()->index(), EventType::BUTTON_PRESS}});
+  CHECK(received.ids == std::vector<int32_t>{0, 0});
+
+  // Events of other buttons are not batched.
+  press(GPIO_NUM_27);
+  CHECK(received.batches.size() == 2);
+}
+
+TEST_CASE("Windowed batches collect events until the window ends or the batch is full") {
+  auto& received = window_batches;
+  REQUIRE(Button::subscribe_batch({a(), b()}, press_events, record, &received, 1000 * ms));
+  CHECK_FALSE(Button::subscribe_batch({a()}, press_events, record, &received));
+  Sim::advance(1000 * ms);
+
+  auto start = Sim::now();
+  press(GPIO_NUM_26);
+  press(GPIO_NUM_27);
+  CHECK(received.batches.empty());
+  Sim::advance(1000 * ms);
+  REQUIRE(received.batches.size() == 1);
+  CHECK(received.times[0] == start + 1020 * ms);
+  CHECK(received.ids[0] == 1);
+  CHECK(received.batches[0] == std::vector<Received>{{a()->index(), EventType::BUTTON_DOWN},
+                                                     {a()->index(), EventType::BUTTON_UP},
+                                                     {a()->index(), EventType::BUTTON_PRESS},
+                                                     {b()->index(), EventType::BUTTON_DOWN},
+                                                     {b()->index(), EventType::BUTTON_UP},
+                                                     {b()->index(), EventType::BUTTON_PRESS}});
+
+  // Six presses are 18 events, the first 16 are posted as soon as the batch is full.
+  for(int i = 0; i < 6; i++) {
+    press(GPIO_NUM_26, 50, 50);
+  }
+  REQUIRE(received.batches.size() == 2);
+  CHECK(received.batches[1].size() == CONFIG_ESP_BE_BATCH_CAPACITY);
+  Sim::advance(1000 * ms);
+  REQUIRE(received.batches.size() == 3);
+  CHECK(received.batches[2].size() == 18 - CONFIG_ESP_BE_BATCH_CAPACITY);
+}
@@ -0,0 +1,81 @@
+#include <esp_idf_button_events/button.hpp>
+#include <esp_idf_button_events/stats.hpp>
+#include <string>
+#include <vector>
+
+#include "doctest.h"
+#include "hal.hpp"
+#include "sim.hpp"
+#include "test_helpers.hpp"
+
+using namespace ButtonEvents;
+using namespace TestHelpers;
+
+namespace {
+  std::vector<std::string> calls;
+
+  void on_loop(void* handler_args, esp_event_base_t base, int32_t id, void* event_data) { calls.push_back("loop"); }
+
+  void on_inline(void* handler_args, esp_event_base_t base, int32_t id, void* event_data) {
+    auto event = EventView(event_data);
+    CHECK(base == BUTTON_EVENT);
+    CHECK(event_id(event.index(), event.event()) == id);
+    calls.push_back("inline");
+  }
+
+  Hal::QueueHandle queue() {
+    static Hal::QueueHandle queue = Hal::queue_create(2, sizeof(EventRecord));
+    return queue;
+  }
+
+  Button* button() {
+    return shared_button(GPIO_NUM_13, [] {
+      Button* b = Button::create("C", GPIO_NUM_13).debounce_ms(20);
+      b->add_handler(on_loop, nullptr, EventType::BUTTON_DOWN);
+      b->add_handler(on_inline, nullptr, EventType::BUTTON_DOWN, Context::INLINE);
+      b->add_handler(queue(), EventType::BUTTON_UP);
+      return b;
+    });
+  }
+
+  void settle() {
+    button();
+    TestHelpers::settle(GPIO_NUM_13);
+    for(EventRecord e; Hal::queue_receive(queue(), &e, 0);) {
+    }
+    calls.clear();
+    reset_stats();
+  }
+}  // namespace
+
+TEST_CASE("Inline handlers run before the event is posted") {
+  settle();
+  press(GPIO_NUM_13, 100, 100);
+  CHECK(calls == std::vector<std::string>{"inline", "loop"});
+}
+
+TEST_CASE("Events are sent to queues, and dropped when full") {
+  settle();
+  auto start = Sim::now();
+  for(int i = 0; i < 3; i++) {
+    press(GPIO_NUM_13, 100, 100);
+  }
+  EventRecord e;
+  REQUIRE(Hal::queue_receive(queue(), &e, 0));
+  CHECK(Button::from_index(e.button) == button());
+  CHECK(e.event == EventType::BUTTON_UP);
+  CHECK(e.timestamp == start + 120 * ms);
+  REQUIRE(Hal::queue_receive(queue(), &e, 0));
+  CHECK(e.timestamp == start + 320 * ms);
+  auto sequence = e.sequence;
+  CHECK_FALSE(Hal::queue_receive(queue(), &e, 0));
+  CHECK(stats().queue_drops == 1);
+  // Only the loop handler's event is posted to the loop.
+  CHECK(stats().posted[static_cast<size_t>(EventType::BUTTON_UP)] == 3);
+  CHECK(stats().queue_high_watermark == 1);
+
+  // The next event received shows the drop as a gap in the sequence.
+  press(GPIO_NUM_13, 100, 100);
+  REQUIRE(Hal::queue_receive(queue(), &e, 0));
+  CHECK(e.sequence == static_cast<uint8_t>(sequence + 2));
+}
@@ -0,0 +1,142 @@
+#include <cstdint>
+#include <esp_idf_button_events/coroutine.hpp>
+#include <mutex>
+#include <vector>
+
+#include "doctest.h"
+
+using namespace Coroutine;
+
+namespace {
+  enum Event { DOWN, UP, PRESS, LONG_PRESS };
+
+  // Stand in for the event manager, using a mutex in place of the FreeRTOS critical section.
+  struct Manager {
+    static void add(void* context, Waiter<int>& waiter) {
+      auto self = static_cast<Manager*>(context);
+      waiter.deadline = waiter.timeout ? self->now + waiter.timeout : no_deadline();
+      self->wakes += self->waiters.push(&waiter);
+    }
+
+    Awaitable<int> next(const void* source, Event event) { return {Manager::add, this, source, 1u << event}; }
+    TimedAwaitable<int> next(const void* source, Event event, uint64_t timeout) { return {Manager::add, this, source, 1u << event, timeout}; }
+
+    size_t dispatch(const void* source, Event event, int value) { return waiters.notify(source, event, value); }
+    size_t advance(uint64_t us) { return waiters.expire(now += us); }
+
+    WaitList<int, std::mutex> waiters;
+    uint64_t now = 0;
+    size_t wakes = 0;
+  };
+
+  const int button_a = 1;
+  const int button_b = 2;
+}  // namespace
+
+TEST_CASE("Coroutine resumes on the awaited event") {
+  Manager manager;
+  std::vector<int> received;
+
+  auto flow = [&]() -> Task {
+    received.push_back(co_await manager.next(&button_a, PRESS));
+    received.push_back(co_await manager.next(&button_a, LONG_PRESS));
+  };
+  flow();
+  CHECK(manager.waiters.empty() == false);
+  CHECK(manager.waiters.next_deadline() == no_deadline());
+
+  SUBCASE("Other events and sources are ignored") {
+    CHECK(manager.dispatch(&button_a, DOWN, 1) == 0);
+    CHECK(manager.dispatch(&button_b, PRESS, 2) == 0);
+    CHECK(received.empty());
+  }
+
+  SUBCASE("Events resume the coroutine in order") {
+    CHECK(manager.dispatch(&button_a, PRESS, 3) == 1);
+    CHECK(received == std::vector<int>{3});
+    CHECK(manager.dispatch(&button_a, PRESS, 4) == 0);
+    CHECK(manager.dispatch(&button_a, LONG_PRESS, 5) == 1);
+    CHECK(received == std::vector<int>{3, 5});
+    CHECK(manager.waiters.empty() == true);
+  }
+}
+
+TEST_CASE("Multiple coroutines wait on the same event") {
+  Manager manager;
+  size_t count = 0;
+
+  auto flow = [&]() -> Task {
+    co_await manager.next(&button_a, UP);
+    count++;
+  };
+  flow();
+  flow();
+  flow();
+  CHECK(manager.dispatch(&button_a, UP, 0) == 3);
+  CHECK(count == 3);
+  CHECK(manager.waiters.empty() == true);
+}
+
+TEST_CASE("Timed waits") {
+  Manager manager;
+  std::vector<bool> results;
+
+  auto flow = [&]() -> Task {
+    co_await manager.next(&button_a, PRESS);
+    auto event = co_await manager.next(&button_a, LONG_PRESS, 2000);
+    results.push_back(event.has_value());
+  };
+  flow();
+  CHECK(manager.dispatch(&button_a, PRESS, 0) == 1);
+  CHECK(manager.waiters.next_deadline() == 2000);
+  CHECK(manager.wakes == 1);
+
+  SUBCASE("Event received before the deadline") {
+    CHECK(manager.advance(1999) == 0);
+    CHECK(manager.dispatch(&button_a, LONG_PRESS, 0) == 1);
+    CHECK(results == std::vector<bool>{true});
+  }
+
+  SUBCASE("Deadline expires") {
+    CHECK(manager.advance(2000) == 1);
+    CHECK(results == std::vector<bool>{false});
+    CHECK(manager.dispatch(&button_a, LONG_PRESS, 0) == 0);
+  }
+  CHECK(manager.waiters.empty() == true);
+  CHECK(manager.waiters.next_deadline() == no_deadline());
+}
+
+TEST_CASE("Earliest deadline is reported on push") {
+  Manager manager;
+  auto flow = [&](uint64_t timeout) -> Task { co_await manager.next(&button_a, PRESS, timeout); };
+
+  flow(5000);
+  CHECK(manager.wakes == 1);
+  flow(8000);
+  CHECK(manager.wakes == 1);
+  flow(1000);
+  CHECK(manager.wakes == 2);
+  CHECK(manager.waiters.next_deadline() == 1000);
+
+  CHECK(manager.advance(1000) == 1);
+  CHECK(manager.waiters.next_deadline() == 5000);
+  CHECK(manager.advance(10000) == 2);
+}
+
+TEST_CASE("Resumed coroutines can wait again on the same list") {
+  Manager manager;
+  size_t presses = 0;
+
+  auto flow = [&]() -> Task {
+    while(presses < 3) {
+      co_await manager.next(&button_a, PRESS);
+      presses++;
+    }
+  };
+  flow();
+  for(size_t i = 0; i < 5; i++) {
+    manager.dispatch(&button_a, PRESS, 0);
+  }
+  CHECK(presses == 3);
+  CHECK(manager.waiters.empty() == true);
+}
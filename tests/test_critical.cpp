@@ -0,0 +1,76 @@
+#include <esp_idf_button_events/button.hpp>
+#include <vector>
+
+#include "doctest.h"
+#include "sim.hpp"
+#include "test_helpers.hpp"
+
+using namespace ButtonEvents;
+using namespace TestHelpers;
+
+namespace {
+  constexpr uint32_t filter_us = 10;
+
+  struct Call {
+    State state;
+    uint64_t time;
+  };
+
+  std::vector<Call> calls;
+  std::vector<EventType> events;
+
+  void stop(Button* button, State state, void* arg) { calls.push_back({state, Sim::now()}); }
+
+  void record(void* handler_args, esp_event_base_t base, int32_t id, void* event_data) { events.push_back(EventData(event_data).event); }
+
+  Button* button() {
+    return shared_button(GPIO_NUM_14, [] {
+      Button* b = Button::create("E", GPIO_NUM_14).debounce_ms(20).critical(stop, nullptr, filter_us);
+      b->add_handler(record, nullptr, EventType::BUTTON_DOWN);
+      return b;
+    });
+  }
+
+  void settle() {
+    button();
+    TestHelpers::settle(GPIO_NUM_14);
+    calls.clear();
+    events.clear();
+  }
+}  // namespace
+
+TEST_CASE("Critical callbacks are called from the ISR") {
+  settle();
+  auto start = Sim::now();
+  Sim::set_level(GPIO_NUM_14, false);
+  REQUIRE(calls.size() == 1);
+  CHECK(calls[0].state == State::PRESSED);
+  CHECK(calls[0].time == start + filter_us);
+  CHECK(events.empty());
+
+  // The normal pipeline still runs.
+  Sim::advance(100 * ms);
+  CHECK(calls.size() == 1);
+  CHECK(events == std::vector<EventType>{EventType::BUTTON_DOWN});
+
+  Sim::set_level(GPIO_NUM_14, true);
+  Sim::advance(100 * ms);
+  REQUIRE(calls.size() == 2);
+  CHECK(calls[1].state == State::NOT_PRESSED);
+}
+
+TEST_CASE("Critical callbacks ignore glitches shorter than the filter") {
+  settle();
+  Sim::set_level_at(GPIO_NUM_14, true, Sim::now() + filter_us / 2);
+  Sim::set_level(GPIO_NUM_14, false);
+  Sim::advance(100 * ms);
+  CHECK(calls.empty());
+  CHECK(events.empty());
+
+  Sim::set_level_at(GPIO_NUM_14, true, Sim::now() + filter_us * 2);
+  Sim::set_level(GPIO_NUM_14, false);
+  Sim::advance(100 * ms);
+  REQUIRE(calls.size() == 2);
+  CHECK(calls[0].state == State::PRESSED);
+  CHECK(calls[1].state == State::NOT_PRESSED);
+}
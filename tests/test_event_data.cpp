@@ -0,0 +1,130 @@
+#include <esp_idf_button_events/button.hpp>
+#include <vector>
+
+#include "doctest.h"
+#include "sim.hpp"
+#include "test_helpers.hpp"
+
+using namespace ButtonEvents;
+using namespace TestHelpers;
+
+namespace {
+  std::vector<EventData> copies;
+
+  void record(void* handler_args, esp_event_base_t base, int32_t id, void* event_data) {
+    auto view = EventView(event_data);
+    auto copy = EventData(event_data);
+    CHECK(view.button() == copy.button);
+    CHECK(view.index() == copy.button->index());
+    CHECK(view.timestamp() == copy.timestamp);
+    CHECK(view.event() == copy.event);
+    CHECK(base == BUTTON_EVENT);
+    CHECK(event_id(view.index(), view.event()) == id);
+    copies.push_back(copy);
+  }
+
+  Button* button() {
+    return shared_button(GPIO_NUM_17, [] {
+      Button* b = Button::create("V", GPIO_NUM_17).debounce_ms(20);
+      b->add_handler(record, nullptr, EventType::BUTTON_DOWN);
+      b->add_handler(record, nullptr, EventType::BUTTON_UP);
+      return b;
+    });
+  }
+
+  int context;
+
+  Button* held_button() {
+    return shared_button(GPIO_NUM_18, [] {
+      Button* b = Button::create("VH", GPIO_NUM_18)
+                    .debounce_ms(20)
+                    .long_press_ms(1000)
+                    .hold_press_ms(500)
+                    .hold_repeat_ms(100)
+                    .context(&context);
+      for(auto event: {EventType::BUTTON_DOWN, EventType::BUTTON_UP, EventType::BUTTON_LONG_PRESS, EventType::BUTTON_HELD}) {
+        b->add_handler(record, nullptr, event);
+      }
+      return b;
+    });
+  }
+}  // namespace
+
+TEST_CASE("Event views read the dispatched record in place") {
+  button();
+  settle(GPIO_NUM_17);
+  auto start = Sim::now();
+  press(GPIO_NUM_17, 100, 100);
+
+  REQUIRE(copies.size() == 2);
+  CHECK(copies[0].button == button());
+  CHECK(copies[0].event == EventType::BUTTON_DOWN);
+  CHECK(copies[0].timestamp == start + 20 * ms);
+  CHECK(copies[1].event == EventType::BUTTON_UP);
+  CHECK(Button::from_index(button()->index()) == button());
+  CHECK(Button::from_index(CONFIG_ESP_BE_MAX_BUTTON_COUNT) == nullptr);
+}
+
+TEST_CASE("Event records carry the press duration, sequence, repeat index and context") {
+  held_button();
+  settle(GPIO_NUM_18);
+  copies.clear();
+  press(GPIO_NUM_18, 1250, 100);
+
+  // DOWN, HELD at 500, 600 ... 1200 ms, UP and LONG_PRESS.
+  REQUIRE(copies.size() == 11);
+  CHECK(copies[0].event == EventType::BUTTON_DOWN);
+  CHECK(copies[0].duration_us == 0);
+  for(size_t i = 1; i < 9; i++) {
+    CHECK(copies[i].event == EventType::BUTTON_HELD);
+    CHECK(copies[i].repeat == i - 1);
+    CHECK(copies[i].duration_us == 500 * ms + (i - 1) * 100 * ms);
+  }
+  CHECK(copies[9].event == EventType::BUTTON_UP);
+  CHECK(copies[9].duration_us == 1250 * ms);
+  CHECK(copies[10].event == EventType::BUTTON_LONG_PRESS);
+  CHECK(copies[10].duration_us == 1250 * ms);
+  CHECK(copies[10].repeat == 0);
+  for(size_t i = 0; i < copies.size(); i++) {
+    CHECK(copies[i].context == &context);
+  }
+  // Each event type is numbered separately.
+  for(size_t i = 1; i < 9; i++) {
+    CHECK(copies[i].sequence == static_cast<uint8_t>(copies[1].sequence + i - 1));
+  }
+}
+
+TEST_CASE("Sequence numbers are consecutive for each event type") {
+  static Button* up_only = shared_button(GPIO_NUM_19, [] {
+    Button* b = Button::create("VU", GPIO_NUM_19).debounce_ms(20).short_press_ms(10);
+    b->add_handler(record, nullptr, EventType::BUTTON_UP);
+    return b;
+  });
+  settle(GPIO_NUM_19);
+  copies.clear();
+  press(GPIO_NUM_19);
+  press(GPIO_NUM_19);
+
+  // The PRESS of the first press and the DOWN of the second fall between the two UPs, but aren't counted.
+  REQUIRE(copies.size() == 2);
+  CHECK(copies[0].button == up_only);
+  CHECK(copies[1].sequence == static_cast<uint8_t>(copies[0].sequence + 1));
+}
+
+TEST_CASE("Buttons with the same name are told apart by their event id") {
+  int first = 0;
+  int second = 0;
+  auto count = [](void* handler_args, esp_event_base_t base, int32_t id, void* event_data) { (*static_cast<int*>(handler_args))++; };
+  Sim::set_level(GPIO_NUM_24, true);
+  Sim::set_level(GPIO_NUM_25, true);
+  Button* a = Button::create("Same", GPIO_NUM_24).debounce_ms(20);
+  Button* b = Button::create("Same", GPIO_NUM_25).debounce_ms(20);
+  a->add_handler(count, &first, EventType::BUTTON_DOWN);
+  b->add_handler(count, &second, EventType::BUTTON_DOWN);
+  Sim::advance(1000 * ms);
+
+  Sim::set_level(GPIO_NUM_24, false);
+  Sim::advance(100 * ms);
+  CHECK(first == 1);
+  CHECK(second == 0);
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <esp_idf_button_events/button.hpp>
+
+#include "sim.hpp"
+
+/**
+ * @brief Helpers shared by the host tests, driving buttons through the simulator. Buttons are active low, so a low
+ *        pin is pressed.
+ */
+namespace TestHelpers {
+  constexpr uint64_t ms = 1000;
+
+  /**
+   * @brief Get a button shared by all test cases of a file, since buttons can't be released. The button is created
+   *        by setup on first use, after its pin is driven released.
+   * @details Each setup lambda has its own type, so each call site holds its own button.
+   * @param pin The pin of the button.
+   * @param setup Creates the button and adds its handlers.
+   * @param released The released level of the pin, low for inverted buttons.
+   * @return ButtonEvents::Button*
+   */
+  template<typename setup_type>
+  ButtonEvents::Button* shared_button(const gpio_num_t pin, setup_type setup, const bool released = true) {
+    static ButtonEvents::Button* button = [&] {
+      Sim::set_level(pin, released);
+      return static_cast<ButtonEvents::Button*>(setup());
+    }();
+    return button;
+  }
+
+  /**
+   * @brief Release a pin and wait for timers of earlier presses to expire.
+   * @param pin The pin to release.
+   * @param idle_ms The time to wait.
+   */
+  inline void settle(const gpio_num_t pin, const uint64_t idle_ms = 1000) {
+    Sim::set_level(pin, true);
+    Sim::advance(idle_ms * ms);
+  }
+
+  /**
+   * @brief Press and release a pin.
+   * @param pin The pin to press.
+   * @param hold_ms The time the pin is held pressed.
+   * @param release_ms The time waited after the release.
+   */
+  inline void press(const gpio_num_t pin, const uint64_t hold_ms = 200, const uint64_t release_ms = 200) {
+    Sim::set_level(pin, false);
+    Sim::advance(hold_ms * ms);
+    Sim::set_level(pin, true);
+    Sim::advance(release_ms * ms);
+  }
+}  // namespace TestHelpers
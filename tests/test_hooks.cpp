@@ -0,0 +1,74 @@
+#include <esp_idf_button_events/button.hpp>
+#include <esp_idf_button_events/hooks.hpp>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include "doctest.h"
+#include "hooks_file_sink.hpp"
+#include "sim.hpp"
+#include "test_helpers.hpp"
+
+using namespace ButtonEvents;
+using namespace TestHelpers;
+using Hooks::Point;
+
+namespace {
+  void ignore(void* handler_args, esp_event_base_t base, int32_t id, void* event_data) {}
+
+  void collect(const Hooks::Record& record, void* arg) { static_cast<std::vector<Hooks::Record>*>(arg)->push_back(record); }
+
+  Button* button() {
+    return shared_button(GPIO_NUM_8, [] {
+      Button* b = Button::create("H", GPIO_NUM_8).debounce_ms(20);
+      b->add_handler(ignore, nullptr, EventType::BUTTON_DOWN);
+      return b;
+    });
+  }
+
+  void press() {
+    button();
+    settle(GPIO_NUM_8);
+    Sim::set_level(GPIO_NUM_8, false);
+    Sim::advance(100 * ms);
+  }
+}  // namespace
+
+TEST_CASE("Hooks follow an event through the pipeline") {
+  std::vector<Hooks::Record> records;
+  button();
+  Hooks::set_sink(collect, &records);
+  auto start = Sim::now();
+  press();
+  Hooks::set_sink(nullptr, nullptr);
+
+  std::vector<Point> points;
+  for(auto& r: records) {
+    if(r.time >= start + 1000 * ms) {
+      points.push_back(r.point);
+    }
+  }
+  CHECK(points == std::vector<Point>{Point::ISR, Point::WAKE_BEGIN, Point::DECODE, Point::WAKE_END, Point::DEBOUNCE_TIMER,
+                                     Point::WAKE_BEGIN, Point::DECODE, Point::POST, Point::WAKE_END, Point::DISPATCH});
+  CHECK(records.back().value == static_cast<uint8_t>(EventType::BUTTON_DOWN));
+  CHECK(records.back().time == start + 1020 * ms);
+}
+
+TEST_CASE("File sink writes a timeline") {
+  const char* path = "test_hooks_timeline.json";
+  {
+    Hooks::FileSink sink(path);
+    REQUIRE(sink.is_open());
+    Hooks::set_sink(Hooks::FileSink::write, &sink);
+    press();
+    Hooks::set_sink(nullptr, nullptr);
+  }
+  std::stringstream content;
+  content << std::ifstream(path).rdbuf();
+  auto json = content.str();
+  CHECK(json.front() == '[');
+  CHECK(json.find("\"name\":\"wake\",\"ph\":\"B\"") != std::string::npos);
+  CHECK(json.find("dispatch b0 BUTTON_DOWN") != std::string::npos);
+  CHECK(json.substr(json.size() - 3) == "\n]\n");
+  std::remove(path);
+}
@@ -0,0 +1,68 @@
+#include <esp_idf_button_events/button.hpp>
+#include <esp_idf_button_events/latency.hpp>
+
+#include "doctest.h"
+#include "sim.hpp"
+#include "test_helpers.hpp"
+
+using namespace ButtonEvents;
+using namespace TestHelpers;
+using Latency::Stage;
+
+namespace {
+  void ignore(void* handler_args, esp_event_base_t base, int32_t id, void* event_data) {}
+
+  Button* button() {
+    return shared_button(GPIO_NUM_4, [] {
+      Button* b = Button::create("L", GPIO_NUM_4).debounce_ms(20);
+      b->add_handler(ignore, nullptr, EventType::BUTTON_DOWN);
+      b->add_handler(ignore, nullptr, EventType::BUTTON_UP);
+      b->add_handler(ignore, nullptr, EventType::BUTTON_PRESS);
+      return b;
+    });
+  }
+
+  void settle() {
+    button();
+    TestHelpers::settle(GPIO_NUM_4);
+    Latency::reset();
+  }
+}  // namespace
+
+TEST_CASE("Log2 buckets") {
+  CHECK(Latency::bucket(0) == 0);
+  CHECK(Latency::bucket(1) == 0);
+  CHECK(Latency::bucket(2) == 1);
+  CHECK(Latency::bucket(1023) == 9);
+  CHECK(Latency::bucket(1024) == 10);
+  CHECK(Latency::bucket(UINT64_MAX) == Latency::bucket_count - 1);
+}
+
+TEST_CASE("Stages of a bouncy press are measured from the first edge") {
+  settle();
+  Sim::set_level(GPIO_NUM_4, false);
+  Sim::advance(1 * ms);
+  Sim::set_level(GPIO_NUM_4, true);
+  Sim::advance(1 * ms);
+  Sim::set_level(GPIO_NUM_4, false);
+  Sim::advance(200 * ms);
+  Sim::set_level(GPIO_NUM_4, true);
+  Sim::advance(100 * ms);
+
+  // DOWN and UP, each 20ms after the first edge of their transition.
+  auto debounce = button()->latency(Stage::DEBOUNCE);
+  CHECK(debounce.count() == 2);
+  CHECK(debounce.counts[Latency::bucket(20 * ms)] == 2);
+  CHECK(debounce.percentile_us(0.5) == 32767);
+  CHECK(button()->latency(Stage::TOTAL).counts[Latency::bucket(20 * ms)] == 2);
+
+  // The simulator runs the manager and loop tasks without delay.
+  CHECK(button()->latency(Stage::TIMER).counts[0] == 2);
+  CHECK(button()->latency(Stage::CLASSIFY).counts[0] == 2);
+  // Queue latency is measured for PRESS too.
+  CHECK(button()->latency(Stage::QUEUE).counts[0] == 3);
+
+  Latency::reset();
+  CHECK(button()->latency(Stage::TOTAL).count() == 0);
+  CHECK(button()->latency(Stage::TOTAL).percentile_us(0.5) == 0);
+}
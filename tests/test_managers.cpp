@@ -0,0 +1,63 @@
+#include <esp_idf_button_events/button.hpp>
+#include <esp_idf_button_events/stats.hpp>
+#include <string>
+#include <vector>
+
+#include "doctest.h"
+#include "event_manager.hpp"
+#include "sim.hpp"
+#include "test_helpers.hpp"
+
+using namespace ButtonEvents;
+using namespace TestHelpers;
+
+namespace {
+  std::vector<std::string> handled;
+
+  void record(void* handler_args, esp_event_base_t base, int32_t id, void* event_data) {
+    handled.push_back(EventView(event_data).button()->name());
+  }
+
+  EventManager* safety() {
+    static EventManager* manager = create_manager({.name = "safety_buttons", .priority = 20, .loop_priority = 21});
+    return manager;
+  }
+
+  void create_buttons() {
+    static bool created = [] {
+      Button* ui = Button::create("UI", GPIO_NUM_15).debounce_ms(20);
+      Button* stop = Button::create("Stop", GPIO_NUM_16).debounce_ms(20).manager(safety());
+      ui->add_handler(record, nullptr, EventType::BUTTON_DOWN);
+      stop->add_handler(record, nullptr, EventType::BUTTON_DOWN);
+      return true;
+    }();
+    (void)created;
+  }
+}  // namespace
+
+TEST_CASE("Buttons are handled by the manager they are bound to") {
+  create_buttons();
+  Sim::set_level(GPIO_NUM_15, true);
+  settle(GPIO_NUM_16);
+  reset_stats();
+
+  // The UI button is pressed first, but both debounce together and the safety manager has the higher priority.
+  Sim::set_level(GPIO_NUM_15, false);
+  Sim::set_level(GPIO_NUM_16, false);
+  Sim::advance(100 * ms);
+  CHECK(handled == std::vector<std::string>{"Stop", "UI"});
+
+  // Statistics are of the default manager, which only saw the UI button.
+  auto s = stats();
+  CHECK(s.posted[static_cast<size_t>(EventType::BUTTON_DOWN)] == 1);
+  CHECK(s.buttons[0].button == Button::from_index(0));
+  CHECK(s.buttons[0].edges == 1);
+  CHECK(s.buttons[1].button == nullptr);
+
+  // Each manager only reports, and resets, its own buttons.
+  auto safety_stats = safety()->stats();
+  CHECK(safety_stats.buttons[0].button == nullptr);
+  CHECK(safety_stats.buttons[1].edges == 1);
+  reset_stats();
+  CHECK(safety()->stats().buttons[1].edges == 1);
+}
@@ -0,0 +1,177 @@
+#include <esp_idf_button_events/button.hpp>
+#include <vector>
+
+#include "doctest.h"
+#include "sim.hpp"
+#include "test_helpers.hpp"
+
+using namespace ButtonEvents;
+using namespace TestHelpers;
+
+namespace {
+  struct Record {
+    const Button* button;
+    EventType event;
+    uint64_t timestamp;
+  };
+
+  std::vector<Record> records;
+
+  void record(void* handler_args, esp_event_base_t base, int32_t id, void* event_data) {
+    auto event = EventData(event_data);
+    records.push_back({event.button, event.event, event.timestamp});
+  }
+
+  // Buttons can't be released, so they are shared by all test cases.
+  Button* button_a() {
+    return shared_button(GPIO_NUM_0, [] {
+      Button* b = Button::create("A", GPIO_NUM_0);
+      for(auto event: {EventType::BUTTON_DOWN, EventType::BUTTON_UP, EventType::BUTTON_PRESS, EventType::BUTTON_LONG_PRESS,
+                       EventType::BUTTON_HELD}) {
+        b->add_handler(record, nullptr, event);
+      }
+      return b;
+    });
+  }
+
+  Button* button_b() {
+    return shared_button(GPIO_NUM_1, [] {
+      Button* b = Button::create("B", GPIO_NUM_1).inverted(true).pull_up(false).pull_down(true).debounce_ms(10).long_press_ms(1000);
+      b->add_handler(record, nullptr, EventType::BUTTON_PRESS);
+      return b;
+    }, false);
+  }
+
+  std::vector<EventType> events() {
+    std::vector<EventType> result;
+    for(auto& r: records) {
+      result.push_back(r.event);
+    }
+    return result;
+  }
+
+  // Leave time for any timers from the previous case to expire.
+  void settle() {
+    button_a();
+    button_b();
+    Sim::set_level(GPIO_NUM_0, true);
+    Sim::set_level(GPIO_NUM_1, false);
+    Sim::advance(10000 * ms);
+    records.clear();
+  }
+}  // namespace
+
+TEST_CASE("Short press") {
+  settle();
+  auto start = Sim::now();
+  Sim::set_level(GPIO_NUM_0, false);
+  Sim::advance(200 * ms);
+  CHECK(button_a()->current_state() == State::PRESSED);
+  Sim::set_level(GPIO_NUM_0, true);
+  Sim::advance(100 * ms);
+  CHECK(button_a()->current_state() == State::NOT_PRESSED);
+
+  CHECK(events() == std::vector<EventType>{EventType::BUTTON_DOWN, EventType::BUTTON_UP, EventType::BUTTON_PRESS});
+  CHECK(records[0].button == button_a());
+  CHECK(records[0].timestamp == start + 50 * ms);
+  CHECK(records[1].timestamp == start + 250 * ms);
+}
+
+TEST_CASE("Press shorter than the short press time is ignored") {
+  settle();
+  Sim::set_level(GPIO_NUM_0, false);
+  Sim::advance(60 * ms);
+  Sim::set_level(GPIO_NUM_0, true);
+  Sim::advance(100 * ms);
+  CHECK(events() == std::vector<EventType>{EventType::BUTTON_DOWN, EventType::BUTTON_UP});
+}
+
+TEST_CASE("Bounces within the debounce time are filtered") {
+  settle();
+  for(int i = 0; i < 5; i++) {
+    Sim::set_level(GPIO_NUM_0, false);
+    Sim::advance(2 * ms);
+    Sim::set_level(GPIO_NUM_0, true);
+    Sim::advance(1 * ms);
+  }
+  Sim::set_level(GPIO_NUM_0, false);
+  Sim::advance(500 * ms);
+  CHECK(events() == std::vector<EventType>{EventType::BUTTON_DOWN});
+}
+
+TEST_CASE("Long press with held repeats") {
+  settle();
+  Sim::set_level(GPIO_NUM_0, false);
+  Sim::advance(4100 * ms);
+  Sim::set_level(GPIO_NUM_0, true);
+  Sim::advance(100 * ms);
+  CHECK(events() == std::vector<EventType>{EventType::BUTTON_DOWN, EventType::BUTTON_HELD, EventType::BUTTON_HELD,
+                                           EventType::BUTTON_HELD, EventType::BUTTON_UP, EventType::BUTTON_LONG_PRESS});
+}
+
+TEST_CASE("Inverted button with a single subscription") {
+  settle();
+  CHECK(button_b()->current_state() == State::NOT_PRESSED);
+  Sim::set_level(GPIO_NUM_1, true);
+  Sim::advance(2000 * ms);
+  CHECK(button_b()->current_state() == State::PRESSED);
+  Sim::set_level(GPIO_NUM_1, false);
+  Sim::advance(100 * ms);
+  // Long press, held, up and down events were not subscribed to.
+  CHECK(records.empty());
+
+  Sim::set_level(GPIO_NUM_1, true);
+  Sim::advance(500 * ms);
+  Sim::set_level(GPIO_NUM_1, false);
+  Sim::advance(100 * ms);
+  CHECK(events() == std::vector<EventType>{EventType::BUTTON_PRESS});
+  CHECK(records[0].button == button_b());
+}
+
+TEST_CASE("Poll only button reads the pin") {
+  settle();
+  static Button* poll = Button::create("Poll", GPIO_NUM_2);
+  Sim::set_level(GPIO_NUM_2, false);
+  CHECK(poll->current_state() == State::PRESSED);
+  Sim::set_level(GPIO_NUM_2, true);
+  CHECK(poll->current_state() == State::NOT_PRESSED);
+}
+
+#if ESP_BE_COROUTINES
+TEST_CASE("Coroutines resume from the event manager") {
+  settle();
+  std::vector<bool> results;
+  auto flow = [&]() -> Coroutine::Task {
+    co_await button_a()->next(EventType::BUTTON_PRESS);
+    auto event = co_await button_a()->next(EventType::BUTTON_LONG_PRESS, 5000);
+    results.push_back(event.has_value());
+  };
+
+  SUBCASE("Long press within the timeout") {
+    flow();
+    Sim::set_level(GPIO_NUM_0, false);
+    Sim::advance(200 * ms);
+    Sim::set_level(GPIO_NUM_0, true);
+    Sim::advance(200 * ms);
+    Sim::set_level(GPIO_NUM_0, false);
+    Sim::advance(3200 * ms);
+    CHECK(results.empty());
+    Sim::set_level(GPIO_NUM_0, true);
+    Sim::advance(100 * ms);
+    CHECK(results == std::vector<bool>{true});
+  }
+
+  SUBCASE("Timeout expires") {
+    flow();
+    Sim::set_level(GPIO_NUM_0, false);
+    Sim::advance(200 * ms);
+    Sim::set_level(GPIO_NUM_0, true);
+    auto released = Sim::now();
+    Sim::advance(4900 * ms);
+    CHECK(results.empty());
+    Sim::advance(200 * ms);
+    CHECK(results == std::vector<bool>{false});
+    CHECK(Sim::now() > released + 5000 * ms);
+  }
+}
+#endif
@@ -0,0 +1,84 @@
+#include <esp_idf_button_events/button.hpp>
+#include <esp_idf_button_events/watchdog.hpp>
+
+#include "doctest.h"
+#include "sim.hpp"
+#include "test_helpers.hpp"
+
+using namespace ButtonEvents;
+using namespace TestHelpers;
+
+namespace {
+  int first_calls = 0;
+  int second_calls = 0;
+  HandlerHandle second;
+
+  void count(void* handler_args, esp_event_base_t base, int32_t id, void* event_data) { (*static_cast<int*>(handler_args))++; }
+
+  // Removes the handler added after it, while the event is being dispatched.
+  void remove_second(void* handler_args, esp_event_base_t base, int32_t id, void* event_data) {
+    first_calls++;
+    Button::remove_handler(second);
+  }
+
+  Button* button() {
+    return shared_button(GPIO_NUM_23, [] { return Button::create("R", GPIO_NUM_23).debounce_ms(20); });
+  }
+}  // namespace
+
+TEST_CASE("Removed handlers are no longer called") {
+  int calls = 0;
+  int inline_calls = 0;
+  auto handle = button()->add_handler(count, &calls, EventType::BUTTON_PRESS);
+  auto inline_handle = button()->add_handler(count, &inline_calls, EventType::BUTTON_PRESS, Context::INLINE);
+  REQUIRE(handle);
+  REQUIRE(inline_handle);
+  press(GPIO_NUM_23);
+  CHECK(calls == 1);
+  CHECK(inline_calls == 1);
+
+  CHECK(Button::remove_handler(handle));
+  CHECK(Button::remove_handler(inline_handle));
+  CHECK_FALSE(Button::remove_handler(handle));
+  CHECK_FALSE(Button::remove_handler(HandlerHandle{}));
+  press(GPIO_NUM_23);
+  CHECK(calls == 1);
+  CHECK(inline_calls == 1);
+}
+
+TEST_CASE("Entries of removed handlers are reused for the same button and event") {
+  int calls = 0;
+  auto count_before = Watchdog::handler_count();
+  auto old_handle = button()->add_handler(count, &calls, EventType::BUTTON_DOWN);
+  REQUIRE(Button::remove_handler(old_handle));
+  auto handle = button()->add_handler(count, &calls, EventType::BUTTON_DOWN);
+  CHECK(handle.index == old_handle.index);
+  CHECK(Watchdog::handler_count() == count_before + 1);
+
+  // The handle of the removed handler doesn't match the reused entry.
+  CHECK_FALSE(Button::remove_handler(old_handle));
+  press(GPIO_NUM_23);
+  CHECK(calls == 1);
+  CHECK(Button::remove_handler(handle));
+}
+
+TEST_CASE("Handlers can be removed while the event is dispatched") {
+  auto first = button()->add_handler(remove_second, nullptr, EventType::BUTTON_UP);
+  second = button()->add_handler(count, &second_calls, EventType::BUTTON_UP);
+  int typed_calls = 0;
+  HandlerHandle typed;
+  typed = button()->add_handler(
+    [&typed_calls, &typed](EventView event) {
+      typed_calls++;
+      Button::remove_handler(typed);
+    },
+    EventType::BUTTON_UP);
+  REQUIRE(typed);
+
+  press(GPIO_NUM_23);
+  press(GPIO_NUM_23);
+  CHECK(first_calls == 2);
+  CHECK(second_calls == 0);
+  CHECK(typed_calls == 1);
+  CHECK(Button::remove_handler(first));
+}
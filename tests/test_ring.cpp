@@ -0,0 +1,113 @@
+#include <esp_idf_button_events/ring.hpp>
+#include <thread>
+#include <vector>
+
+#include "doctest.h"
+#include "sim.hpp"
+#include "test_helpers.hpp"
+
+using namespace ButtonEvents;
+using namespace TestHelpers;
+
+namespace {
+  std::vector<EventType> read_all(EventRing::Reader& reader) {
+    std::vector<EventType> events;
+    EventRecord record;
+    while(reader.next(record)) {
+      events.push_back(record.event);
+    }
+    return events;
+  }
+}  // namespace
+
+TEST_CASE("Ring readers read the event stream at their own pace") {
+  Sim::set_level(GPIO_NUM_28, true);
+  Button* button = Button::create("Ring", GPIO_NUM_28).debounce_ms(20);
+  Sim::advance(1000 * ms);
+
+  auto ui = ring_reader(event_mask(EventType::BUTTON_PRESS));
+  auto log = ring_reader(event_mask(EventType::BUTTON_DOWN) | event_mask(EventType::BUTTON_UP));
+  press(GPIO_NUM_28);
+  CHECK(ui.pending() == 1);
+  CHECK(log.pending() == 2);
+
+  EventRecord record;
+  REQUIRE(ui.next(record));
+  CHECK(EventView(&record).button() == button);
+  CHECK(record.event == EventType::BUTTON_PRESS);
+  CHECK_FALSE(ui.next(record));
+  CHECK(ui.pending() == 0);
+
+  // The second reader hasn't moved, and only sees its own events.
+  CHECK(read_all(log) == std::vector<EventType>{EventType::BUTTON_DOWN, EventType::BUTTON_UP});
+  CHECK(ui.lost() == 0);
+  CHECK(log.lost() == 0);
+
+  // Readers start at the next event.
+  auto late = ring_reader();
+  CHECK(late.pending() == 0);
+}
+
+TEST_CASE("Readers cover buttons created after them") {
+  auto reader = ring_reader(event_mask(EventType::BUTTON_PRESS));
+  Sim::set_level(GPIO_NUM_29, true);
+  Button* later = Button::create("Later", GPIO_NUM_29).debounce_ms(20);
+  Sim::advance(1000 * ms);
+
+  press(GPIO_NUM_29);
+  EventRecord record;
+  REQUIRE(reader.next(record));
+  CHECK(EventView(&record).button() == later);
+  CHECK(record.event == EventType::BUTTON_PRESS);
+  CHECK_FALSE(reader.next(record));
+}
+
+TEST_CASE("Readers falling more than a ring behind count lost events") {
+  auto reader = ring_reader(event_mask(EventType::BUTTON_PRESS));
+  auto presses = EventRing::size / 3 + 2;
+  for(size_t i = 0; i < presses; i++) {
+    press(GPIO_NUM_28);
+  }
+  auto events = read_all(reader);
+  CHECK(reader.lost() == presses * 3 - EventRing::size);
+  // The ring holds the last DOWN, UP, PRESS triples, of which the reader only reads the presses.
+  CHECK(events == std::vector<EventType>((EventRing::size + 2) / 3, EventType::BUTTON_PRESS));
+}
+
+TEST_CASE("Readers never see torn records while the writer laps them") {
+  constexpr uint32_t count = 200000;
+  static EventRing ring;
+  std::vector<EventRing::Reader> readers(2, EventRing::Reader(ring));
+  std::vector<std::thread> threads;
+  std::vector<uint32_t> read(readers.size());
+  std::vector<bool> ordered(readers.size(), true);
+  for(size_t i = 0; i < readers.size(); i++) {
+    threads.emplace_back([&, i] {
+      auto& reader = readers[i];
+      EventRecord record;
+      uint64_t last = 0;
+      while(last + 1 < count) {
+        if(!reader.next(record)) {
+          std::this_thread::yield();
+          continue;
+        }
+        // Each record carries its position in every field, a torn copy mixes two positions.
+        auto position = record.timestamp;
+        ordered[i] = ordered[i] && position >= last && record.duration_us == static_cast<uint32_t>(position) &&
+                     record.sequence == static_cast<uint8_t>(position);
+        last = position;
+        read[i]++;
+      }
+    });
+  }
+  for(uint32_t i = 0; i < count; i++) {
+    ring.publish({.timestamp = i, .duration_us = i, .button = 0, .event = EventType::BUTTON_DOWN, .sequence = static_cast<uint8_t>(i)});
+  }
+  for(auto& thread: threads) {
+    thread.join();
+  }
+  for(size_t i = 0; i < readers.size(); i++) {
+    CHECK(ordered[i]);
+    CHECK(read[i] + readers[i].lost() == count);
+  }
+}
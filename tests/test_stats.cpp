@@ -0,0 +1,102 @@
+#include <esp_idf_button_events/button.hpp>
+#include <esp_idf_button_events/stats.hpp>
+#include <string>
+
+#include "doctest.h"
+#include "event_manager.hpp"
+#include "sim.hpp"
+#include "test_helpers.hpp"
+
+using namespace ButtonEvents;
+using namespace TestHelpers;
+
+namespace {
+  constexpr gpio_num_t pins[] = {GPIO_NUM_5, GPIO_NUM_6, GPIO_NUM_7};
+  constexpr const char* names[] = {"S0", "S1", "S2"};
+
+  void ignore(void* handler_args, esp_event_base_t base, int32_t id, void* event_data) {}
+
+  void create_buttons() {
+    static bool created = [] {
+      for(size_t i = 0; i < 3; i++) {
+        Button* b = Button::create(names[i], pins[i]).debounce_ms(20);
+        for(auto event: {EventType::BUTTON_DOWN, EventType::BUTTON_UP, EventType::BUTTON_PRESS}) {
+          b->add_handler(ignore, nullptr, event);
+        }
+      }
+      return true;
+    }();
+    (void)created;
+  }
+
+  void set_all(bool level) {
+    for(auto pin: pins) {
+      Sim::set_level(pin, level);
+    }
+  }
+
+  void settle() {
+    create_buttons();
+    set_all(true);
+    Sim::advance(1000 * ms);
+    reset_stats();
+  }
+}  // namespace
+
+TEST_CASE("Edges, wakes and posts are counted") {
+  settle();
+  Sim::set_level(GPIO_NUM_5, false);
+  Sim::advance(1 * ms);
+  Sim::set_level(GPIO_NUM_5, true);
+  Sim::advance(1 * ms);
+  Sim::set_level(GPIO_NUM_5, false);
+  Sim::advance(200 * ms);
+  Sim::set_level(GPIO_NUM_5, true);
+  Sim::advance(100 * ms);
+
+  auto s = stats();
+  CHECK(s.buttons[0].button->name() == std::string("S0"));
+  CHECK(s.buttons[0].edges == 4);
+  CHECK(s.buttons[0].spurious == 0);
+  CHECK(s.buttons[1].edges == 0);
+  CHECK(s.posted[static_cast<size_t>(EventType::BUTTON_DOWN)] == 1);
+  CHECK(s.posted[static_cast<size_t>(EventType::BUTTON_UP)] == 1);
+  CHECK(s.posted[static_cast<size_t>(EventType::BUTTON_PRESS)] == 1);
+  CHECK(s.posted[static_cast<size_t>(EventType::BUTTON_LONG_PRESS)] == 0);
+  // A press and a debounce expiry for each transition.
+  CHECK(s.wakes == 4);
+  CHECK(s.decoded == 4);
+  CHECK(s.max_decoded_per_wake == 1);
+  CHECK(s.blocked_posts == 0);
+  CHECK(s.queue_high_watermark >= 1);
+}
+
+TEST_CASE("A glitch which doesn't change the debounced state is spurious") {
+  settle();
+  Sim::set_level(GPIO_NUM_6, false);
+  Sim::advance(1 * ms);
+  Sim::set_level(GPIO_NUM_6, true);
+  Sim::advance(100 * ms);
+  auto s = stats();
+  CHECK(s.buttons[1].edges == 2);
+  CHECK(s.buttons[1].spurious == 1);
+}
+
+TEST_CASE("Posts to a full event loop queue are counted as blocked") {
+  settle();
+  set_all(false);
+  Sim::advance(200 * ms);
+  reset_stats();
+  // All debounce timers expire together and are decoded in one wake, which posts an UP and a PRESS per button.
+  set_all(true);
+  Sim::advance(100 * ms);
+  auto s = stats();
+  CHECK(s.max_decoded_per_wake == 3);
+  CHECK(s.queue_high_watermark == CONFIG_ESP_BE_EVENT_LOOP_QUEUE_SIZE + 1);
+  // With more than one loop the posts are spread over several queues, none of which fills.
+  CHECK(s.blocked_posts == (event_loop_count() == 1 ? 1 : 0));
+
+  reset_stats();
+  CHECK(stats().blocked_posts == 0);
+  CHECK(stats().buttons[0].edges == 0);
+}
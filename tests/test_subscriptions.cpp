@@ -0,0 +1,62 @@
+#include <esp_idf_button_events/button.hpp>
+#include <vector>
+
+#include "doctest.h"
+#include "sim.hpp"
+#include "test_helpers.hpp"
+
+using namespace ButtonEvents;
+using namespace TestHelpers;
+
+namespace {
+  struct Received {
+    size_t index;
+    EventType event;
+    bool operator==(const Received&) const = default;
+  };
+
+  std::vector<Received> pair_events;
+  std::vector<Received> all;
+
+  void record(void* handler_args, esp_event_base_t base, int32_t id, void* event_data) {
+    auto event = EventView(event_data);
+    static_cast<std::vector<Received>*>(handler_args)->push_back({event.index(), event.event()});
+  }
+}  // namespace
+
+TEST_CASE("Subscriptions cover a set of events on a set of buttons") {
+  for(auto pin: {GPIO_NUM_20, GPIO_NUM_21, GPIO_NUM_22}) {
+    Sim::set_level(pin, true);
+  }
+  Button* a = Button::create("SA", GPIO_NUM_20).debounce_ms(20);
+  Button* b = Button::create("SB", GPIO_NUM_21).debounce_ms(20);
+  Button* c = Button::create("SC", GPIO_NUM_22).debounce_ms(20);
+  Sim::advance(1000 * ms);
+
+  CHECK(Button::subscribe({a, b}, event_mask(EventType::BUTTON_DOWN) | event_mask(EventType::BUTTON_PRESS), record, &pair_events));
+  CHECK(Button::subscribe_all(all_events(), record, &all));
+  CHECK_FALSE(Button::subscribe({}, all_events(), record, &all));
+
+  press(GPIO_NUM_20);
+  press(GPIO_NUM_22);
+  press(GPIO_NUM_21);
+
+  CHECK(pair_events == std::vector<Received>{{a->index(), EventType::BUTTON_DOWN},
+                                             {a->index(), EventType::BUTTON_PRESS},
+                                             {b->index(), EventType::BUTTON_DOWN},
+                                             {b->index(), EventType::BUTTON_PRESS}});
+  REQUIRE(all.size() == 9);
+  CHECK(all[3] == Received{c->index(), EventType::BUTTON_DOWN});
+  CHECK(all[4] == Received{c->index(), EventType::BUTTON_UP});
+  CHECK(all[5] == Received{c->index(), EventType::BUTTON_PRESS});
+}
+
+TEST_CASE("Subscriptions are refused when the table is full") {
+  Button* a = Button::from_index(0);
+  REQUIRE(a);
+  size_t added = 0;
+  while(Button::subscribe({a}, event_mask(EventType::BUTTON_HELD), record, &all)) {
+    added++;
+  }
+  CHECK(added == CONFIG_ESP_BE_MAX_SUBSCRIPTIONS - 2);
+}
@@ -0,0 +1,109 @@
+#include <esp_idf_button_events/button.hpp>
+#include <esp_idf_button_events/trace.hpp>
+#include <vector>
+
+#include "doctest.h"
+#include "sim.hpp"
+#include "test_helpers.hpp"
+
+using namespace ButtonEvents;
+using namespace TestHelpers;
+
+namespace {
+  void ignore(void* handler_args, esp_event_base_t base, int32_t id, void* event_data) {}
+
+  Button* button() {
+    return shared_button(GPIO_NUM_3, [] {
+      Button* b = Button::create("T", GPIO_NUM_3).debounce_ms(20).long_press_ms(1000);
+      b->add_handler(ignore, nullptr, EventType::BUTTON_DOWN);
+      b->add_handler(ignore, nullptr, EventType::BUTTON_PRESS);
+      return b;
+    });
+  }
+
+  std::vector<uint8_t> dump() {
+    std::vector<uint8_t> buffer(Trace::dump_size());
+    buffer.resize(Trace::dump(buffer.data(), buffer.size()));
+    return buffer;
+  }
+
+  std::vector<Trace::Record> decode(const std::vector<uint8_t>& buffer) {
+    std::vector<Trace::Record> records;
+    Trace::Reader reader(buffer.data(), buffer.size());
+    for(Trace::Record record; reader.next(record);) {
+      records.push_back(record);
+    }
+    return records;
+  }
+
+  void settle() {
+    button();
+    TestHelpers::settle(GPIO_NUM_3);
+    Trace::clear();
+  }
+}  // namespace
+
+TEST_CASE("Trace records edges and posted events") {
+  settle();
+  auto start = Sim::now();
+  Sim::set_level(GPIO_NUM_3, false);
+  Sim::advance(1 * ms);
+  Sim::set_level(GPIO_NUM_3, true);
+  Sim::advance(1 * ms);
+  Sim::set_level(GPIO_NUM_3, false);
+  Sim::advance(200 * ms);
+  Sim::set_level(GPIO_NUM_3, true);
+  Sim::advance(100 * ms);
+
+  auto buffer = dump();
+  Trace::Reader reader(buffer.data(), buffer.size());
+  REQUIRE(reader.valid());
+  REQUIRE(reader.button_count() == 1);
+  CHECK(reader.button(0).debounce_us == 20 * ms);
+  CHECK(reader.button(0).long_press_us == 1000 * ms);
+  CHECK_FALSE(reader.button(0).inverted);
+  CHECK(reader.button(0).events == (event_mask(EventType::BUTTON_DOWN) | event_mask(EventType::BUTTON_PRESS)));
+  CHECK(reader.start_time() == start);
+
+  // BUTTON_UP is not subscribed, so it is not posted or recorded.
+  auto records = decode(buffer);
+  REQUIRE(records.size() == 6);
+  CHECK_FALSE(records[0].is_event);
+  CHECK_FALSE(records[0].level);
+  CHECK(records[1].time == start + 1 * ms);
+  CHECK(records[1].level);
+  CHECK(records[3].is_event);
+  CHECK(records[3].event == EventType::BUTTON_DOWN);
+  CHECK(records[3].time == start + 20 * ms);
+  CHECK_FALSE(records[4].is_event);
+  CHECK(records[4].time == start + 202 * ms);
+  CHECK(records[5].event == EventType::BUTTON_PRESS);
+  CHECK(records[5].time == start + 222 * ms);
+}
+
+TEST_CASE("Trace ring keeps the newest records when full") {
+  settle();
+  for(int i = 0; i < 1000; i++) {
+    Sim::set_level(GPIO_NUM_3, i % 2);
+    Sim::advance(300 * ms);
+  }
+  auto buffer = dump();
+  CHECK(buffer.size() <= Trace::dump_size());
+  auto records = decode(buffer);
+  REQUIRE(records.size() > 100);
+  CHECK(records.back().is_event);
+  CHECK(records.back().event == EventType::BUTTON_PRESS);
+  CHECK(records.back().time == Sim::now() - 300 * ms + 20 * ms);
+  for(size_t i = 1; i < records.size(); i++) {
+    CHECK(records[i].time >= records[i - 1].time);
+  }
+}
+
+TEST_CASE("Trace dump fails on a short buffer") {
+  settle();
+  Sim::set_level(GPIO_NUM_3, false);
+  Sim::advance(100 * ms);
+  uint8_t buffer[8];
+  CHECK(Trace::dump(buffer, sizeof(buffer)) == 0);
+  CHECK_FALSE(Trace::Reader(buffer, 0).valid());
+}
@@ -0,0 +1,106 @@
+#include <esp_idf_button_events/button.hpp>
+#include <memory>
+#include <vector>
+
+#include "doctest.h"
+#include "sim.hpp"
+#include "test_helpers.hpp"
+
+using namespace ButtonEvents;
+using namespace TestHelpers;
+
+namespace {
+  struct Counter {
+    std::vector<EventType> events;
+    void on_event(EventView event) { events.push_back(event.event()); }
+  };
+
+  struct Functor {
+    std::vector<uint64_t>* timestamps;
+    void operator()(EventView event) const { timestamps->push_back(event.timestamp()); }
+  };
+
+  std::vector<HandlerHandle> fillers;
+}  // namespace
+
+TEST_CASE("Typed handlers are called with the event") {
+  Sim::set_level(GPIO_NUM_19, true);
+  Button* button = Button::create("TH", GPIO_NUM_19).debounce_ms(20);
+  Sim::advance(1000 * ms);
+
+  int presses = 0;
+  Button* seen = nullptr;
+  Counter counter;
+  std::vector<uint64_t> timestamps;
+  std::vector<EventType> inline_events;
+
+  CHECK(button->add_handler(
+    [&presses, &seen](EventView event) {
+      presses++;
+      seen = event.button();
+    },
+    EventType::BUTTON_PRESS));
+  CHECK(button->add_handler(&counter, &Counter::on_event, EventType::BUTTON_DOWN));
+  CHECK(button->add_handler(&counter, &Counter::on_event, EventType::BUTTON_UP));
+  CHECK(button->add_handler(Functor{&timestamps}, EventType::BUTTON_UP));
+  CHECK(button->add_handler([&inline_events](EventView event) { inline_events.push_back(event.event()); }, EventType::BUTTON_DOWN,
+                            Context::INLINE));
+
+  auto start = Sim::now();
+  press(GPIO_NUM_19);
+  CHECK(presses == 1);
+  CHECK(seen == button);
+  CHECK(counter.events == std::vector<EventType>{EventType::BUTTON_DOWN, EventType::BUTTON_UP});
+  REQUIRE(timestamps.size() == 1);
+  CHECK(timestamps[0] == start + 220 * ms);
+  CHECK(inline_events == std::vector<EventType>{EventType::BUTTON_DOWN});
+}
+
+TEST_CASE("Typed handlers are refused when the table is full") {
+  Button* button = Button::from_index(0);
+  REQUIRE(button);
+  while(auto handle = button->add_handler([](EventView event) {}, EventType::BUTTON_HELD)) {
+    fillers.push_back(handle);
+  }
+  CHECK(fillers.size() == CONFIG_ESP_BE_MAX_TYPED_HANDLERS - 5);
+  CHECK_FALSE(button->add_handler([](EventView event) {}, EventType::BUTTON_HELD));
+}
+
+TEST_CASE("Removed typed handlers aren't reused while they run") {
+  Sim::set_level(GPIO_NUM_20, true);
+  static Button* button = Button::create("TR", GPIO_NUM_20).debounce_ms(20);
+  Sim::advance(1000 * ms);
+
+  // Frees an entry for the handler under test, leaving the table full once it is added.
+  REQUIRE(Button::remove_handler(fillers.back()));
+  fillers.pop_back();
+  static HandlerHandle self;
+  static HandlerHandle replacement;
+  static int seen = 0;
+  self = button->add_handler(
+    [captured = 42](EventView event) {
+      Button::remove_handler(self);
+      replacement = button->add_handler([captured = 7](EventView event) { seen = captured; }, EventType::BUTTON_PRESS);
+      seen = captured;
+    },
+    EventType::BUTTON_PRESS);
+  REQUIRE(self);
+
+  press(GPIO_NUM_20);
+  CHECK(seen == 42);
+  CHECK_FALSE(replacement);
+
+  // Once it has returned, its entry is reused.
+  CHECK(button->add_handler([](EventView event) {}, EventType::BUTTON_PRESS));
+}
+
+TEST_CASE("Inplace functions destroy their callable") {
+  auto shared = std::make_shared<int>(0);
+  InplaceFunction<EventView, 4 * sizeof(void*)> function;
+  CHECK_FALSE(function);
+  function.emplace([shared](EventView event) {});
+  CHECK(function);
+  CHECK(shared.use_count() == 2);
+  function.reset();
+  CHECK(shared.use_count() == 1);
+}
@@ -0,0 +1,80 @@
+#include <esp_idf_button_events/button.hpp>
+#include <esp_idf_button_events/watchdog.hpp>
+#include <vector>
+
+#include "doctest.h"
+#include "sim.hpp"
+#include "test_helpers.hpp"
+
+using namespace ButtonEvents;
+using namespace TestHelpers;
+
+namespace {
+  uint64_t down_us = 0;
+  std::vector<uint64_t> handled;
+
+  // Handlers take virtual time, so they can be made to overrun the budget.
+  void slow_down(void* handler_args, esp_event_base_t base, int32_t id, void* event_data) { Sim::spend(down_us); }
+
+  void record(void* handler_args, esp_event_base_t base, int32_t id, void* event_data) { handled.push_back(Sim::now()); }
+
+  void collect(const Watchdog::Overrun& overrun, void* arg) { static_cast<std::vector<Watchdog::Overrun>*>(arg)->push_back(overrun); }
+
+  Button* button() {
+    return shared_button(GPIO_NUM_9, [] {
+      Button* b = Button::create("W", GPIO_NUM_9).debounce_ms(20);
+      b->add_handler(slow_down, nullptr, EventType::BUTTON_DOWN);
+      b->add_handler(record, nullptr, EventType::BUTTON_UP);
+      return b;
+    });
+  }
+
+  void press_settled() {
+    button();
+    settle(GPIO_NUM_9);
+    press(GPIO_NUM_9, 100, 100);
+  }
+
+  Watchdog::HandlerStats find(esp_event_handler_t handler) {
+    for(size_t i = 0; i < Watchdog::handler_count(); i++) {
+      if(Watchdog::handler_stats(i).handler == handler) {
+        return Watchdog::handler_stats(i);
+      }
+    }
+    return {};
+  }
+}  // namespace
+
+TEST_CASE("Watchdog times handlers within budget") {
+  down_us = 1 * ms;
+  auto before = find(slow_down);
+  press_settled();
+  auto after = find(slow_down);
+  REQUIRE(after.button == button());
+  CHECK(after.event == EventType::BUTTON_DOWN);
+  CHECK(after.calls == before.calls + 1);
+  CHECK(after.overruns == before.overruns);
+  CHECK(after.max_us >= 1 * ms);
+  CHECK(find(record).calls > 0);
+}
+
+TEST_CASE("Watchdog reports handlers over budget") {
+  std::vector<Watchdog::Overrun> overruns;
+  Watchdog::set_callback(collect, &overruns);
+  Watchdog::set_budget_us(5 * ms);
+  down_us = 8 * ms;
+  auto before = find(slow_down);
+  press_settled();
+  Watchdog::set_callback(nullptr, nullptr);
+  Watchdog::set_budget_us(CONFIG_ESP_BE_HANDLER_BUDGET_US);
+
+  REQUIRE(overruns.size() == 1);
+  CHECK(overruns[0].button == button());
+  CHECK(overruns[0].event == EventType::BUTTON_DOWN);
+  CHECK(overruns[0].handler == slow_down);
+  CHECK(overruns[0].duration_us == 8 * ms);
+  CHECK(overruns[0].budget_us == 5 * ms);
+  auto after = find(slow_down);
+  CHECK(after.overruns == before.overruns + 1);
+  CHECK(after.max_us == 8 * ms);
+}
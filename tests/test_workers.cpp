@@ -0,0 +1,96 @@
+#include <esp_idf_button_events/button.hpp>
+#include <vector>
+
+#include "doctest.h"
+#include "event_manager.hpp"
+#include "sim.hpp"
+#include "test_helpers.hpp"
+
+using namespace ButtonEvents;
+using namespace TestHelpers;
+
+namespace {
+  constexpr gpio_num_t pins[] = {GPIO_NUM_10, GPIO_NUM_11, GPIO_NUM_12};
+  constexpr const char* names[] = {"P0", "P1", "P2"};
+
+  struct Handled {
+    const Button* button;
+    EventType event;
+    uint64_t time;
+  };
+
+  std::vector<Button*> buttons;
+  std::vector<Handled> handled;
+
+  void record(void* handler_args, esp_event_base_t base, int32_t id, void* event_data) {
+    auto event = EventData(event_data);
+    handled.push_back({event.button, event.event, Sim::now()});
+  }
+
+  // Blocks its loop task for 100ms, pressing the other buttons meanwhile.
+  void slow(void* handler_args, esp_event_base_t base, int32_t id, void* event_data) {
+    record(handler_args, base, id, event_data);
+    Sim::set_level(pins[1], false);
+    Sim::set_level(pins[2], false);
+    Sim::advance(100 * ms);
+  }
+
+  void create_buttons() {
+    if(!buttons.empty()) {
+      return;
+    }
+    for(size_t i = 0; i < 3; i++) {
+      buttons.push_back(Button::create(names[i], pins[i]).debounce_ms(20));
+      buttons[i]->add_handler(i == 0 ? slow : record, nullptr, EventType::BUTTON_DOWN);
+      buttons[i]->add_handler(record, nullptr, EventType::BUTTON_UP);
+    }
+  }
+
+  void settle() {
+    create_buttons();
+    for(auto pin: pins) {
+      Sim::set_level(pin, true);
+    }
+    Sim::advance(1000 * ms);
+    handled.clear();
+  }
+
+  std::vector<Handled> of(const Button* button) {
+    std::vector<Handled> result;
+    for(auto& h: handled) {
+      if(h.button == button) {
+        result.push_back(h);
+      }
+    }
+    return result;
+  }
+}  // namespace
+
+TEST_CASE("A slow handler only delays buttons on its own loop") {
+  REQUIRE(event_loop_count() == 2);
+  settle();
+  auto start = Sim::now();
+  Sim::set_level(pins[0], false);
+  Sim::advance(200 * ms);
+
+  // Button 1 is on the second loop, so its press is handled while the first loop is blocked.
+  auto second = of(buttons[1]);
+  REQUIRE(second.size() == 1);
+  CHECK(second[0].time == start + 40 * ms);
+  // Button 2 shares the blocked loop, and waits for the slow handler to return.
+  auto shared = of(buttons[2]);
+  REQUIRE(shared.size() == 1);
+  CHECK(shared[0].time == start + 120 * ms);
+}
+
+TEST_CASE("Events of a button stay in order") {
+  settle();
+  for(int i = 0; i < 4; i++) {
+    press(pins[2], 50, 50);
+  }
+  auto events = of(buttons[2]);
+  REQUIRE(events.size() == 8);
+  for(size_t i = 0; i < events.size(); i++) {
+    CHECK(events[i].event == (i % 2 ? EventType::BUTTON_UP : EventType::BUTTON_DOWN));
+  }
+}
@@ -0,0 +1,188 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <esp_idf_button_events/button.hpp>
+#include <esp_idf_button_events/trace.hpp>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "sim.hpp"
+
+// Replays a trace dump through the button engine in the simulator, faster than real time, and compares the events
+// emitted by the replay with those recorded on the device.
+//
+// Usage: replay_trace DUMP [--verbose] [--tolerance US]
+// Exits with 1 if the replayed events differ from the recorded events, so dumps can be used as a regression corpus.
+
+using namespace ButtonEvents;
+
+namespace {
+  constexpr size_t max_buttons = CONFIG_ESP_BE_MAX_BUTTON_COUNT;
+  constexpr std::array<const char*, 8> names{"replay0", "replay1", "replay2", "replay3", "replay4", "replay5", "replay6", "replay7"};
+  constexpr std::array<const char*, 5> event_names{"BUTTON_UP", "BUTTON_DOWN", "BUTTON_PRESS", "BUTTON_LONG_PRESS", "BUTTON_HELD"};
+
+  struct Event {
+    uint64_t time;  ///< Time relative to the start of the trace, in us.
+    EventType event;
+  };
+
+  std::array<Button*, max_buttons> buttons = {};
+  std::array<std::vector<Event>, max_buttons> replayed;
+  uint64_t offset = 0;
+  bool verbose = false;
+
+  size_t index_of(const Button* button) { return std::find(buttons.begin(), buttons.end(), button) - buttons.begin(); }
+
+  void handler(void* handler_args, esp_event_base_t base, int32_t id, void* event_data) {
+    auto event = EventData(event_data);
+    auto index = index_of(event.button);
+    replayed[index].push_back({event.timestamp - offset, event.event});
+    if(verbose) {
+      std::printf("%12.3f ms  button %zu  replayed %s\n", (event.timestamp - offset) / 1e3, index,
+                  event_names[static_cast<size_t>(event.event)]);
+    }
+  }
+
+  std::vector<uint8_t> read_file(const char* path) {
+    std::ifstream file(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+  }
+}  // namespace
+
+int main(int argc, char** argv) {
+  const char* path = nullptr;
+  uint64_t tolerance = 5000;
+  for(int i = 1; i < argc; i++) {
+    if(!std::strcmp(argv[i], "--verbose")) {
+      verbose = true;
+    }
+    else if(!std::strcmp(argv[i], "--tolerance") && i + 1 < argc) {
+      tolerance = std::atoll(argv[++i]);
+    }
+    else {
+      path = argv[i];
+    }
+  }
+  if(!path) {
+    std::fprintf(stderr, "Usage: replay_trace DUMP [--verbose] [--tolerance US]\n");
+    return 2;
+  }
+
+  auto dump = read_file(path);
+  Trace::Reader reader(dump.data(), dump.size());
+  if(!reader.valid()) {
+    std::fprintf(stderr, "%s: not a trace dump\n", path);
+    return 2;
+  }
+
+  // Decode everything up front, the initial pin levels are only known from the first edge of each button.
+  std::vector<Trace::Record> records;
+  for(Trace::Record record; reader.next(record);) {
+    records.push_back(record);
+  }
+  std::array<bool, max_buttons> initial_level;
+  std::array<bool, max_buttons> pressed_level;
+  std::array<uint64_t, max_buttons> first_press;
+  initial_level.fill(true);
+  pressed_level.fill(false);
+  first_press.fill(UINT64_MAX);
+  for(size_t i = 0; i < reader.button_count(); i++) {
+    pressed_level[reader.button(i).index % max_buttons] = reader.button(i).inverted;
+  }
+  for(auto it = records.rbegin(); it != records.rend(); it++) {
+    if(!it->is_event && it->button < max_buttons) {
+      initial_level[it->button] = !it->level;
+      first_press[it->button] = it->level == pressed_level[it->button] ? it->time : first_press[it->button];
+    }
+  }
+
+  for(size_t i = 0; i < reader.button_count(); i++) {
+    auto& c = reader.button(i);
+    if(c.index >= max_buttons) {
+      continue;
+    }
+    auto pin = static_cast<gpio_num_t>(c.index);
+    Sim::set_level(pin, initial_level[c.index]);
+    buttons[c.index] = Button::create(names[c.index], pin)
+                         .inverted(c.inverted)
+                         .debounce_ms(c.debounce_us / 1000)
+                         .short_press_ms(c.short_press_us / 1000)
+                         .long_press_ms(c.long_press_us / 1000)
+                         .hold_press_ms(c.hold_press_us / 1000)
+                         .hold_repeat_ms(c.hold_repeat_us / 1000);
+    // Only subscribed events were recorded, and held events are only classified when subscribed.
+    for(auto event: {EventType::BUTTON_UP, EventType::BUTTON_DOWN, EventType::BUTTON_PRESS, EventType::BUTTON_LONG_PRESS,
+                     EventType::BUTTON_HELD}) {
+      if(c.events & event_mask(event)) {
+        buttons[c.index]->add_handler(handler, nullptr, event);
+      }
+    }
+  }
+
+  // Events of a button before its first recorded press can't be reproduced, since the start of the press in
+  // progress was overwritten. They are not compared.
+  std::array<std::vector<Event>, max_buttons> recorded;
+  size_t edges = 0;
+  offset = Sim::now() + 1;
+  auto wall_start = std::chrono::steady_clock::now();
+  for(auto& record: records) {
+    auto time = record.time - reader.start_time();
+    if(record.button >= max_buttons || !buttons[record.button]) {
+      continue;
+    }
+    if(record.is_event) {
+      if(record.time >= first_press[record.button]) {
+        recorded[record.button].push_back({time, record.event});
+      }
+      if(verbose) {
+        std::printf("%12.3f ms  button %u  recorded %s\n", time / 1e3, record.button,
+                    event_names[static_cast<size_t>(record.event) % event_names.size()]);
+      }
+      continue;
+    }
+    Sim::advance_to(offset + time);
+    Sim::set_level(static_cast<gpio_num_t>(record.button), record.level);
+    edges++;
+    if(verbose) {
+      std::printf("%12.3f ms  button %u  edge %s\n", time / 1e3, record.button, record.level ? "high" : "low");
+    }
+  }
+  auto span = records.empty() ? 0 : records.back().time - reader.start_time();
+  // Let pending debounce timers fire. Replayed events after the end of the trace are not compared.
+  Sim::advance_to(offset + span + 1000000);
+  auto wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - wall_start).count();
+
+  size_t mismatches = 0;
+  size_t recorded_count = 0;
+  size_t replayed_count = 0;
+  for(size_t b = 0; b < max_buttons; b++) {
+    auto& r = recorded[b];
+    auto& p = replayed[b];
+    auto from = first_press[b] - std::min(first_press[b], reader.start_time());
+    auto end = std::remove_if(p.begin(), p.end(), [&](const Event& e) { return e.time < from || e.time > span + tolerance; });
+    p.erase(end, p.end());
+    recorded_count += r.size();
+    replayed_count += p.size();
+    for(size_t i = 0; i < std::max(r.size(), p.size()); i++) {
+      if(i < r.size() && i < p.size() && r[i].event == p[i].event &&
+         (r[i].time > p[i].time ? r[i].time - p[i].time : p[i].time - r[i].time) <= tolerance) {
+        continue;
+      }
+      mismatches++;
+      std::printf("button %zu event %zu: recorded %s at %.3f ms, replayed %s at %.3f ms\n", b, i,
+                  i < r.size() ? event_names[static_cast<size_t>(r[i].event) % event_names.size()] : "nothing",
+                  i < r.size() ? r[i].time / 1e3 : 0.0, i < p.size() ? event_names[static_cast<size_t>(p[i].event)] : "nothing",
+                  i < p.size() ? p[i].time / 1e3 : 0.0);
+    }
+  }
+
+  std::printf("%zu edges, %zu recorded events, %zu replayed events, %zu mismatches\n", edges, recorded_count, replayed_count,
+              mismatches);
+  std::printf("replayed %.3f s in %.3f ms, %.0fx real time\n", span / 1e6, wall_ns / 1e6,
+              wall_ns ? span * 1e3 / wall_ns : 0.0);
+  return mismatches ? 1 : 0;
+}
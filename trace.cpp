@@ -0,0 +1,167 @@
+#include "trace_recorder.hpp"
+
+#ifdef CONFIG_ESP_BE_TRACE
+
+  #include <algorithm>
+  #include <array>
+  #include <iterator>
+  #include <mutex>
+
+  #include "hal.hpp"
+
+namespace ButtonEvents::Trace {
+  namespace {
+    /**
+     * @brief Byte ring of variable length records. The oldest whole records are dropped to make space.
+     */
+    class Ring {
+     public:
+      // Called from the button ISR, so it is kept in IRAM with the functions it calls.
+      void IRAM_ATTR push(const uint8_t header) {
+        std::lock_guard<Hal::CriticalSection> guard(_lock);
+        // ISR and task records may read the time out of order, deltas are never negative.
+        auto now = std::max(Hal::time_us(), _last);
+        if(!_used) {
+          _start = _last = now;
+        }
+        uint8_t record[max_record_size];
+        size_t size = 0;
+        record[size++] = header;
+        auto delta = now - _last;
+        do {
+          uint8_t byte = delta & 0x7F;
+          delta >>= 7;
+          record[size++] = byte | (delta ? 0x80 : 0);
+        } while(delta);
+        while(_used + size > _data.size()) {
+          _drop();
+        }
+        for(size_t i = 0; i < size; i++) {
+          _data[(_head + _used++) % _data.size()] = record[i];
+        }
+        _last = now;
+      }
+
+      size_t size() {
+        std::lock_guard<Hal::CriticalSection> guard(_lock);
+        return _used;
+      }
+
+      /**
+       * @brief Copy out the records, oldest first.
+       * @return true The records were copied.
+       * @return false The buffer is too small.
+       */
+      bool copy(uint8_t* buffer, const size_t size, size_t& used, uint64_t& start) {
+        std::lock_guard<Hal::CriticalSection> guard(_lock);
+        if(size < _used) {
+          return false;
+        }
+        for(size_t i = 0; i < _used; i++) {
+          buffer[i] = _at(i);
+        }
+        used = _used;
+        start = _start;
+        return true;
+      }
+
+      void clear() {
+        std::lock_guard<Hal::CriticalSection> guard(_lock);
+        _head = _used = 0;
+      }
+
+     private:
+      uint8_t IRAM_ATTR _at(const size_t offset) const { return _data[(_head + offset) % _data.size()]; }
+
+      // The start time moves forward by the delta of the dropped record, which is what the next delta is relative to.
+      void IRAM_ATTR _drop() {
+        size_t size = 1;
+        uint64_t delta = 0;
+        for(size_t shift = 0;; shift += 7) {
+          auto byte = _at(size++);
+          delta |= static_cast<uint64_t>(byte & 0x7F) << shift;
+          if(!(byte & 0x80)) {
+            break;
+          }
+        }
+        _start += delta;
+        _head = (_head + size) % _data.size();
+        _used -= size;
+      }
+
+      std::array<uint8_t, CONFIG_ESP_BE_TRACE_BUFFER_SIZE> _data = {};
+      size_t _head = 0;
+      size_t _used = 0;
+      uint64_t _start = 0;
+      uint64_t _last = 0;
+      Hal::CriticalSection _lock;
+    };
+
+    Ring ring;
+    std::array<ButtonConfig, CONFIG_ESP_BE_MAX_BUTTON_COUNT> configs;
+    std::array<bool, CONFIG_ESP_BE_MAX_BUTTON_COUNT> configured = {};
+
+    size_t header_size() {
+      size_t buttons = 0;
+      for(auto c: configured) {
+        buttons += c;
+      }
+      return sizeof(magic) + 1 + buttons * button_config_size + sizeof(uint64_t);
+    }
+
+    uint8_t* write_fixed(uint8_t* out, uint64_t value, const size_t bytes) {
+      for(size_t i = 0; i < bytes; i++, value >>= 8) {
+        *out++ = value & 0xFF;
+      }
+      return out;
+    }
+  }  // namespace
+
+  void record_button(const ButtonConfig& config) {
+    configs[config.index] = config;
+    configured[config.index] = true;
+  }
+
+  void record_subscription(const size_t button, const uint8_t events) { configs[button].events |= events; }
+
+  void IRAM_ATTR record_edge(const size_t button, const bool level) { ring.push(record_header(false, button, level)); }
+
+  void record_event(const size_t button, const EventType event) {
+    ring.push(record_header(true, button, static_cast<uint8_t>(event)));
+  }
+
+  size_t dump_size() { return header_size() + ring.size(); }
+
+  size_t dump(uint8_t* buffer, const size_t size) {
+    auto header = header_size();
+    if(size < header) {
+      return 0;
+    }
+    size_t records = 0;
+    uint64_t start = 0;
+    if(!ring.copy(buffer + header, size - header, records, start)) {
+      return 0;
+    }
+
+    auto out = std::copy(std::begin(magic), std::end(magic), buffer);
+    *out++ = (header - sizeof(magic) - 1 - sizeof(uint64_t)) / button_config_size;
+    for(size_t i = 0; i < configs.size(); i++) {
+      if(!configured[i]) {
+        continue;
+      }
+      auto& c = configs[i];
+      *out++ = c.index;
+      *out++ = c.inverted;
+      for(auto value: {c.debounce_us, c.short_press_us, c.long_press_us, c.hold_press_us, c.hold_repeat_us}) {
+        out = write_fixed(out, value, sizeof(uint32_t));
+      }
+      *out++ = c.events;
+    }
+    write_fixed(out, start, sizeof(uint64_t));
+    return header + records;
+  }
+
+  void clear() { ring.clear(); }
+}  // namespace ButtonEvents::Trace
+
+#endif
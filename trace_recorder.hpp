@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <esp_idf_button_events/trace.hpp>
+
+#ifdef CONFIG_ESP_BE_TRACE
+
+/**
+ * @brief Internal recording interface of the trace ring. The dump interface is public, in trace.hpp.
+ */
+namespace ButtonEvents::Trace {
+  /**
+   * @brief Record the configuration of a button, once its interrupt is attached.
+   * @param config The button configuration.
+   */
+  void record_button(const ButtonConfig& config);
+
+  /**
+   * @brief Record events subscribed for a button, once it is recorded.
+   * @param button The button index.
+   * @param events A mask of the events.
+   */
+  void record_subscription(const size_t button, const uint8_t events);
+
+  /**
+   * @brief Record a raw pin edge. Safe to call from an ISR.
+   * @param button The button index.
+   * @param level The pin level read in the ISR.
+   */
+  void record_edge(const size_t button, const bool level);
+
+  /**
+   * @brief Record an event posted for a button.
+   * @param button The button index.
+   * @param event The event type.
+   */
+  void record_event(const size_t button, const EventType event);
+}  // namespace ButtonEvents::Trace
+
+#endif